@@ -0,0 +1,46 @@
+#ifndef ACTIVE_SET_H
+#define ACTIVE_SET_H
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// ACTIVE NODE SET
+// ================================
+
+// Nodes that currently hold queued vehicles. A dense bitset answers
+// membership in O(1) and a worklist with back-pointers supports O(1) insert
+// and erase, so engine loops cost O(active) per tick instead of O(nodes).
+// Mutation is single-writer (the thread holding the coordinator lock);
+// contains() may be called concurrently from other threads.
+class ActiveNodeSet {
+public:
+    void reset(size_t node_count);
+
+    // Both return true when membership changed
+    bool insert(size_t node);
+    bool erase(size_t node);
+
+    bool contains(size_t node) const;
+    size_t size() const { return worklist.size(); }
+    bool empty() const { return worklist.empty(); }
+
+    // Active nodes in ascending order; a copy, so callers may mutate the set
+    // while iterating it.
+    vector<uint32_t> snapshot() const;
+
+private:
+    static constexpr uint32_t NOT_ACTIVE = UINT32_MAX;
+
+    unique_ptr<atomic<uint64_t>[]> bits;
+    size_t capacity = 0;
+    vector<uint32_t> worklist;
+    vector<uint32_t> position;
+};
+
+#endif // ACTIVE_SET_H
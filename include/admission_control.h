@@ -0,0 +1,80 @@
+#ifndef ADMISSION_CONTROL_H
+#define ADMISSION_CONTROL_H
+
+#include "data_structures.h"
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// ENTRY ADMISSION CONTROL
+// ================================
+
+// Ramp metering at network entry points. New demand waits in a bounded
+// per-entry buffer and enters the network through a token bucket refilled
+// at the entry's metering rate (vehicles per tick, fractional allowed),
+// and only while the entry node has a free slot. A full buffer pushes back
+// on the demand generator: arrivals it cannot hold are deferred, never
+// created, so held-back traffic costs at most buffer_capacity vehicles per
+// entry however long the overload lasts.
+struct EntryPoint {
+    int node = -1;
+    double meter_rate = 1.0;
+    double tokens = 0.0;
+    deque<Vehicle> buffer;
+    uint64_t generated = 0;
+    uint64_t admitted = 0;
+    uint64_t deferred = 0;
+};
+
+class AdmissionController {
+public:
+    void configure(size_t buffer_capacity) { capacity = buffer_capacity; }
+    void add_entry(int node, double meter_rate);
+    void clear() { entries.clear(); }
+
+    bool empty() const { return entries.empty(); }
+    size_t entry_count() const { return entries.size(); }
+    const EntryPoint& entry(size_t k) const { return entries[k]; }
+
+    // Backpressure: how many new arrivals entry k can hold right now
+    size_t room(size_t k) const;
+    void hold(size_t k, const Vehicle& vehicle) { entries[k].buffer.push_back(vehicle); entries[k].generated++; }
+    void defer(size_t k, size_t count) { entries[k].deferred += count; }
+
+    // One metering tick: refill every bucket, then hand buffered vehicles
+    // to admit(node, vehicle) in FIFO order until the bucket is empty or
+    // admit refuses. Burst is capped at max(1, meter_rate) per tick.
+    template<class Admit>
+    size_t release(Admit&& admit);
+
+    size_t buffered() const;
+    uint64_t generated() const;
+    uint64_t admitted() const;
+    uint64_t deferred() const;
+
+private:
+    vector<EntryPoint> entries;
+    size_t capacity = 10;
+};
+
+template<class Admit>
+size_t AdmissionController::release(Admit&& admit) {
+    size_t released = 0;
+    for (EntryPoint& entry : entries) {
+        entry.tokens = min(entry.tokens + entry.meter_rate, max(1.0, entry.meter_rate));
+        while (entry.tokens >= 1.0 && !entry.buffer.empty() && admit(entry.node, entry.buffer.front())) {
+            entry.buffer.pop_front();
+            entry.tokens -= 1.0;
+            entry.admitted++;
+            released++;
+        }
+    }
+    return released;
+}
+
+#endif // ADMISSION_CONTROL_H
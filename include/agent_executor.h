@@ -0,0 +1,94 @@
+#ifndef AGENT_EXECUTOR_H
+#define AGENT_EXECUTOR_H
+
+#include <vector>
+#include <queue>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+// ================================
+// AGENT EVENTS
+// ================================
+
+namespace AgentEvent {
+    constexpr uint8_t NONE = 0;
+    constexpr uint8_t VEHICLE_ARRIVED = 1 << 0;
+    constexpr uint8_t CAPACITY_FREED = 1 << 1;
+    constexpr uint8_t TIMER = 1 << 2;
+}
+
+// What a suspended agent is waiting for: any of the event bits, or the timer
+// when timeout is non-zero. An agent that awaits nothing is finished.
+struct AgentAwait {
+    uint8_t events = AgentEvent::NONE;
+    chrono::milliseconds timeout{0};
+};
+
+// ================================
+// AGENT EXECUTOR
+// ================================
+
+// Runs many lightweight, resumable agents on whichever threads call run().
+// Agents are plain state machines: the executor keeps only a few bytes of
+// scheduling state per agent and calls the shared step function with the
+// events that woke it. The step function returns what to await next.
+class AgentExecutor {
+public:
+    using AgentId = uint32_t;
+    using StepFunction = function<AgentAwait(AgentId agent, uint8_t fired)>;
+
+    void reset(size_t agent_count, StepFunction step);
+
+    // Wakes the agent if it is waiting on any of the given events. Events that
+    // arrive while the agent is running are delivered on its next await.
+    void signal(AgentId agent, uint8_t events);
+
+    // Schedules every agent once so it can issue its first await.
+    void start();
+
+    // Executes ready agents and fires timers until stop() is called.
+    void run();
+    void stop();
+
+    size_t agent_count() const { return agents.size(); }
+    uint64_t resumptions() const { return resume_count.load(); }
+
+private:
+    struct AgentSlot {
+        chrono::steady_clock::time_point deadline;
+        uint32_t timer_generation = 0;
+        uint8_t awaiting = AgentEvent::NONE;
+        uint8_t pending = AgentEvent::NONE;
+        bool queued = false;
+        bool running = false;
+    };
+
+    struct TimerEntry {
+        chrono::steady_clock::time_point deadline;
+        AgentId agent;
+        uint32_t generation;
+        bool operator>(const TimerEntry& other) const { return deadline > other.deadline; }
+    };
+
+    void make_ready(AgentId agent);
+    void suspend(AgentId agent, const AgentAwait& await);
+
+    vector<AgentSlot> agents;
+    deque<AgentId> ready;
+    priority_queue<TimerEntry, vector<TimerEntry>, greater<TimerEntry>> timers;
+    StepFunction step_function;
+
+    mutex executor_mutex;
+    condition_variable executor_cv;
+    bool stopping = false;
+    atomic<uint64_t> resume_count{0};
+};
+
+#endif // AGENT_EXECUTOR_H
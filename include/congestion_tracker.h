@@ -0,0 +1,59 @@
+#ifndef CONGESTION_TRACKER_H
+#define CONGESTION_TRACKER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// CONGESTION RANKING
+// ================================
+
+// Ordered by utilization, then queue depth, then blocked attempts since
+// the node last let a vehicle through
+struct CongestionKey {
+    float utilization = 0.0f;
+    int32_t queue_depth = 0;
+    int32_t blocked = 0;
+
+    bool operator<(const CongestionKey& other) const {
+        if (utilization != other.utilization) return utilization < other.utilization;
+        if (queue_depth != other.queue_depth) return queue_depth < other.queue_depth;
+        return blocked < other.blocked;
+    }
+    bool operator==(const CongestionKey& other) const {
+        return utilization == other.utilization && queue_depth == other.queue_depth && blocked == other.blocked;
+    }
+};
+
+// Indexed binary max-heap over every node, so a key change is one sift
+// from the node's known heap position: O(log n). The K hottest nodes are
+// read without a scan or sort by walking the heap best-first from the
+// root with a small frontier heap: O(K log K).
+class CongestionTracker {
+public:
+    void build(const vector<CongestionKey>& initial);
+    void clear();
+
+    size_t size() const { return heap.size(); }
+    const CongestionKey& key(size_t node) const { return keys[node]; }
+
+    void update(size_t node, const CongestionKey& key);
+
+    // Up to k node ids, hottest first; ties go to the lower id
+    void top(size_t k, vector<uint32_t>& out) const;
+
+private:
+    bool hotter(uint32_t a, uint32_t b) const;
+    void place(size_t slot, uint32_t node);
+    void sift_up(size_t slot);
+    void sift_down(size_t slot);
+
+    vector<CongestionKey> keys;     // by node
+    vector<uint32_t> heap;          // node ids
+    vector<uint32_t> slot_of;       // node -> heap slot
+};
+
+#endif // CONGESTION_TRACKER_H
@@ -0,0 +1,26 @@
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// CPU AFFINITY AND NUMA TOPOLOGY
+// ================================
+
+// Thin wrappers over the Linux affinity interface and sysfs topology. On
+// other platforms every call degrades to a no-op that reports failure (or a
+// single NUMA node), so callers can treat pinning as a best-effort hint.
+namespace CpuTopology {
+    // CPUs the process is allowed to run on, in ascending order.
+    vector<int> allowed_cpus();
+
+    // NUMA node that owns the given CPU (0 when unknown).
+    int numa_node_of_cpu(int cpu);
+
+    bool pin_current_thread(int cpu);
+}
+
+#endif // CPU_TOPOLOGY_H
@@ -2,6 +2,8 @@
 #define DATA_STRUCTURES_H
 
 #include "types.h"
+#include "window_metrics.h"
+#include "fairness_monitor.h"
 #include <vector>
 #include <queue>
 #include <chrono>
@@ -22,12 +24,15 @@ struct Vehicle {
     int current_node;
     chrono::steady_clock::time_point arrival_time;
     chrono::steady_clock::time_point start_time;
-    vector<int> path;
+    vector<int> path;               // replayed trips only; empty means free routing
+    size_t path_step = 0;           // index of current_node in path
     int blocked_attempts = 0;
+    AgedTicket queue_stamp;         // when the vehicle joined its current node's queue
+    bool traced = false;            // sampled for VehicleTracer when created
+    uint8_t priority;               // emergency queue rank at the current node
 
     Vehicle(int id, VehicleType t, int src, int dest);
     bool operator<(const Vehicle& other) const;
-    double get_priority_weight() const;
     string to_string() const;
     string get_type_display() const;
 };
@@ -58,14 +63,81 @@ struct SystemConfig {
     double max_emergency_wait = 2.0;
     int retry_delay_ms = 100;
     double simulation_time = 20.0;
-    double w1 = 0.5, w2 = 0.5, wa = 10.0, wf = 8.0;
+    double w1 = 0.5, w2 = 0.5;
     double max_block_time = 30.0;
+    double shutdown_timeout = 2.0;     // Total join deadline in seconds
+    double flow_time_step = 0.5;       // Mesoscopic sweep length in seconds
+    SignalPolicy signal_policy = SignalPolicy::NONE;
+    string signal_plan_file = "signal_plan.txt";
+    int optimizer_horizon = 200;       // Ticks per candidate evaluation
+    int optimizer_rounds = 50;
+    int max_green_ticks = 6;
+
+    // Shared-memory live state for external viewers; empty disables
+    string state_export_name;
+
+    // Key for every counter-based random draw (philox.h)
+    uint64_t random_seed = 1;
+
+    // Delay distributions (delay_model.h). TRAVEL_TIME is the default for
+    // every edge; SERVICE_TIME, when set, replaces one vehicle per token
+    string travel_time = "FIXED 100";
+    string service_time;
+
+    // Demand at # Entry Points, metered into the network (admission_control.h)
+    double demand_rate = 0.0;          // Mean new vehicles per tick per entry
+    int entry_buffer = 10;             // Vehicles held back per entry
+
+    // Sliding-window metrics (window_metrics.h)
+    double metrics_bucket = 0.25;      // Seconds per bucket
+    int metrics_history = 240;         // Buckets kept
+    double metrics_window = 5.0;       // Seconds reported as "recent"
+
+    // Nodes shown by congestion dashboards; larger networks list only these
+    int top_k_nodes = 10;
+
+    // Sampled vehicle tracing (vehicle_trace.h); a rate of 0 disables
+    double trace_sample_rate = 0.0;    // Fraction of vehicles traced
+    string trace_file = "vehicle_trace.csv";
+    int trace_buffer = 1 << 20;        // Events kept before dropping
+
+    // Early termination (steady_state.h)
+    EarlyStop early_stop = EarlyStop::DRAIN;
+    double steady_precision = 0.05;    // CI half-width relative to the mean
+    int steady_batches = 10;
+
+    // Control environment (ENV_BENCHMARK)
+    int env_count = 64;
+    int env_steps = 1000;
+    int env_episode_ticks = 200;
+    double env_arrival_rate = 0.5;     // Mean new vehicles per tick
+
+    // Node Coordinates are lat, lon degrees when true, planar x, y otherwise
+    bool geographic_coordinates = false;
+
+    // GPS traces map-matched into replayed trips; empty disables
+    string gps_trace_file;
+    string matched_trips_file = "matched_trips.txt";
+    double gps_sigma = 0.0;            // 0 derives from mean edge length
+    double gps_search_radius = 0.0;
+
+    // DIFFERENTIAL_CHECK
+    int diff_scenarios = 200;
+    int diff_max_ticks = 300;
+    uint64_t diff_seed = 1;
     bool enable_colors = true;
     int console_refresh_rate = 1000;
     bool show_step_details = true;
     bool auto_advance_steps = false;
 
+    // Worker placement
+    int worker_threads = 4;
+    bool pin_worker_threads = false;
+
     void load_defaults();
+    // Applies a "KEY: value" line from the input's configuration sections.
+    // Returns false for unknown keys.
+    bool apply_option(const string& key, const string& value);
 };
 
 struct SystemStats {
@@ -77,11 +149,17 @@ struct SystemStats {
     int rerouting_attempts = 0;
     int total_moves = 0;
     int step_count = 0;
+    double total_travel_ms = 0.0;
+    double max_travel_ms = 0.0;
+    int timed_moves = 0;
     chrono::steady_clock::time_point start_time;
+    double simulated_seconds = -1.0;    // clock of flow and hybrid runs; wall time when negative
+    WindowMetrics windows;
 
     SystemStats();
     double get_success_rate() const;
     double get_throughput() const;
+    double elapsed_seconds() const;
 };
 
 #endif // DATA_STRUCTURES_H
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef DELAY_MODEL_H
+#define DELAY_MODEL_H
+
+#include "types.h"
+#include "philox.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// DELAY DISTRIBUTIONS
+// ================================
+
+// A travel or service time distribution in milliseconds, written as
+//   FIXED 100
+//   LOGNORMAL 100 0.5        mean, coefficient of variation
+//   GAMMA 100 0.8            mean, coefficient of variation
+//   EMPIRICAL 80 95 110 400  observed samples
+// Every kind is sampled by inverse CDF from one uniform, so a tick's draws
+// come from a single counter-based batch and need no rejection loop.
+// Gamma uses the Wilson-Hilferty cube-root normal approximation.
+struct DelayModel {
+    DelayDistribution kind = DelayDistribution::FIXED;
+    double mean_ms = 0.0;
+    double cv = 0.0;
+    vector<double> samples;     // EMPIRICAL, sorted
+
+    static bool parse(const string& text, DelayModel& model);
+    string describe() const;
+
+    double quantile(double u) const;
+
+private:
+    void prepare();
+
+    double mu = 0.0;            // LOGNORMAL location
+    double sigma = 0.0;         // LOGNORMAL scale
+    double wh_a = 0.0;          // GAMMA: mean * (1 - 1/(9k)) terms
+    double wh_b = 0.0;
+};
+
+// Standard normal quantile (Acklam's rational approximation, |error| < 1.2e-9)
+double inverse_normal_cdf(double p);
+
+// out[i] = models[model_of[i]].quantile(uniform(streams[i], tick, purpose))
+// with the uniforms generated as one batch.
+void sample_delays(const CounterRng& rng, const vector<DelayModel>& models,
+                   const uint32_t* streams, const uint16_t* model_of, size_t n,
+                   uint32_t tick, RandomPurpose purpose, vector<double>& uniforms, float* out);
+
+#endif // DELAY_MODEL_H
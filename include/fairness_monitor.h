@@ -0,0 +1,102 @@
+#ifndef FAIRNESS_MONITOR_H
+#define FAIRNESS_MONITOR_H
+
+#include <vector>
+#include <deque>
+#include <unordered_set>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// FAIRNESS AND STARVATION
+// ================================
+
+// One node's queue for one vehicle class
+struct FairnessStream {
+    uint64_t offered = 0;       // vehicles that joined the node's queue
+    uint64_t served = 0;        // vehicles that left it by moving on
+    uint64_t blocks = 0;        // failed moves, kept across reroutes
+    double total_wait = 0.0;    // seconds queued by the served vehicles
+    double max_wait = 0.0;
+    uint32_t alarms = 0;        // times the stream crossed the threshold
+    bool starving = false;
+};
+
+// Stamp given to a vehicle when it joins a node's queue; a vehicle
+// returned to the queue after a failed move keeps its stamp
+struct AgedTicket {
+    uint64_t ticket = 0;        // 0 means untracked
+    double since = 0.0;         // seconds since reset()
+};
+
+// Aged FIFOs per (node, class). Tickets are issued in time order, so the
+// oldest vehicle still queued is the first live entry: joining and leaving
+// are O(1), with vehicles that leave out of order skipped lazily when they
+// reach the front. Service fairness is the served/offered ratio of each
+// stream; Jain's index over the streams of a class is kept from running
+// sums of the ratios and their squares, so it is also O(1) per event.
+class FairnessMonitor {
+public:
+    void reset(size_t node_count, size_t class_count);
+    void set_alarm_seconds(double seconds) { alarm_seconds = seconds; }
+
+    double clock() const;
+
+    AgedTicket join(size_t node, size_t cls);
+    void leave(size_t node, size_t cls, const AgedTicket& stamp);     // served
+    void drop(size_t node, size_t cls, const AgedTicket& stamp);      // removed unserved
+    void block(size_t node, size_t cls);
+
+    // Raises an alarm when a stream's oldest vehicle has been queued
+    // longer than the threshold; O(classes)
+    void check(size_t node);
+
+    // Seconds the oldest queued vehicle of the stream has waited
+    double oldest_age(size_t node, size_t cls);
+
+    const FairnessStream& stream(size_t node, size_t cls) const { return streams[node * classes + cls]; }
+    size_t node_count() const { return classes > 0 ? streams.size() / classes : 0; }
+    size_t class_count() const { return classes; }
+    double alarm_threshold() const { return alarm_seconds; }
+
+    double jain_index(size_t cls) const;
+    double jain_index() const;          // over every stream
+    size_t fair_streams(size_t cls) const { return class_sums[cls].n; }
+    size_t starving_streams() const { return starving_now; }
+    uint64_t total_alarms() const { return alarms_raised; }
+
+private:
+    struct Entry {
+        uint64_t ticket;
+        double since;
+    };
+    struct Queue {
+        deque<Entry> fifo;
+        unordered_set<uint64_t> departed;
+    };
+    struct RatioSums {
+        double sum = 0.0;
+        double sum_sq = 0.0;
+        size_t n = 0;
+    };
+
+    void retire(size_t index, uint64_t ticket);
+    void evaluate(size_t index, double now);
+    void adjust_ratio(size_t index, uint64_t offered, uint64_t served);
+    static double jain(double sum, double sum_sq, size_t n);
+
+    size_t classes = 0;
+    vector<FairnessStream> streams;
+    vector<Queue> queues;
+    vector<RatioSums> class_sums;
+    chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+    double alarm_seconds = 30.0;
+    uint64_t next_ticket = 1;
+    size_t starving_now = 0;
+    uint64_t alarms_raised = 0;
+};
+
+#endif // FAIRNESS_MONITOR_H
@@ -0,0 +1,115 @@
+#ifndef FAST_FORWARD_H
+#define FAST_FORWARD_H
+
+#include "data_structures.h"
+#include "signal_control.h"
+#include "vehicle_classes.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// READ-ONLY NETWORK SNAPSHOT
+// ================================
+
+// Everything a headless run needs, copied once from the loaded network and
+// then shared read-only by any number of simulators on any thread.
+struct NetworkSnapshot {
+    struct InitialVehicle {
+        int node;
+        int destination;
+        VehicleType type;
+        int vehicle_id;              // creation order, breaks emergency rank ties
+    };
+
+    size_t node_count = 0;
+    vector<int> capacity;
+    vector<int32_t> class_limit;     // [node * VEHICLE_CLASS_COUNT + class], as the engine's
+    vector<uint8_t> class_priority;  // emergency queue rank, same layout
+    vector<int> destination_row;     // [node] -> routing row, -1 if never a destination
+    vector<int> destinations;        // [row] -> node
+    vector<int> next_hop;            // [row * node_count + node], -1 when unreachable
+    vector<InitialVehicle> vehicles; // queue order, emergency before regular per node
+    const SignalController* signals = nullptr;
+
+    void build(const vector<NodeData>& nodes, const SignalController& controller,
+               const vector<int32_t>& limits, const vector<uint8_t>& priorities);
+};
+
+// ================================
+// FAST-FORWARD SIMULATOR
+// ================================
+
+// Deterministic tick engine with the live engine's rules and no sleeping or
+// locking: each tick every node serves the head of its queue (emergency
+// first, by the node's class ranks) if the next hop is under the class's
+// limit and, for regular vehicles, shows green.
+// Vehicles that arrive during a tick wait for the next one. A tick is one
+// token cycle, so a plan evaluation over hundreds of ticks takes well under
+// a millisecond on small networks.
+class FastForwardSimulator {
+public:
+    explicit FastForwardSimulator(const NetworkSnapshot& network);
+
+    void reset();
+
+    // Green approach per controller for the next tick (NO_PHASE = all open)
+    void set_green(size_t controller, int approach) { green[controller] = approach; }
+    void apply_plan(const SignalPlan& plan);
+    void step();
+
+    // Inserts a vehicle into node's queue if the node has room for its class
+    // and destination has a routing row. Returns the vehicle index or -1.
+    int add_vehicle(int node, int destination, VehicleType type);
+
+    // Runs from the initial state and returns the plan's cost: vehicle-ticks
+    // spent in the network, with vehicles still inside charged to the horizon.
+    double evaluate(const SignalPlan* plan, size_t horizon_ticks);
+
+    size_t tick() const { return current_tick; }
+    int in_network() const { return vehicles_in_network; }
+    int completed() const { return vehicles_completed; }
+    long long vehicle_ticks() const { return total_vehicle_ticks; }
+    int queue_length(size_t node) const;
+    int occupancy_at(size_t node) const { return occupancy[node]; }
+
+private:
+    // Per-node FIFO backed by a vector; head advances and the buffer compacts
+    // once the consumed prefix dominates.
+    struct NodeQueue {
+        vector<int> items;
+        size_t head = 0;
+
+        bool empty() const { return head == items.size(); }
+        size_t size() const { return items.size() - head; }
+        int front() const { return items[head]; }
+        void push(int v) { items.push_back(v); }
+        void pop();
+        void clear() { items.clear(); head = 0; }
+    };
+
+    void enqueue(int vehicle, int node);
+    bool served_after(int a, int b, int node) const;
+
+    const NetworkSnapshot& net;
+
+    vector<int> vehicle_destination;
+    vector<uint8_t> vehicle_class_of;
+    vector<int> vehicle_order;
+    vector<size_t> vehicle_moved_tick;
+
+    vector<NodeQueue> regular_queue;
+    vector<NodeQueue> emergency_queue;
+    vector<int> occupancy;
+    vector<int> green;
+
+    size_t current_tick = 0;
+    int next_order = 0;
+    int vehicles_in_network = 0;
+    int vehicles_completed = 0;
+    long long total_vehicle_ticks = 0;
+};
+
+#endif // FAST_FORWARD_H
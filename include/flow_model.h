@@ -0,0 +1,152 @@
+#ifndef FLOW_MODEL_H
+#define FLOW_MODEL_H
+
+#include "data_structures.h"
+#include "vehicle_classes.h"
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// ================================
+// MESOSCOPIC FLOW MODEL
+// ================================
+
+// Aggregate KPIs accumulated by the flow model, in vehicles and seconds.
+struct FlowKpis {
+    double simulated_time = 0.0;
+    double vehicles_moved = 0.0;
+    double completed_regular = 0.0;
+    double completed_emergency = 0.0;
+    double vehicle_seconds = 0.0;     // integral of vehicles in network over time
+    size_t sweeps = 0;
+};
+
+// Cell-transmission style model over the same graph and capacities as the
+// vehicle engine. Each edge holds the stock routed onto it at its tail
+// node, split into through stock and stock that exits at the head. Every
+// sweep runs dense loops over these per-edge arrays:
+//   1. per-node sending ratio (service rate * dt / occupancy)
+//   2. through demand arriving at each node
+//   3. receiving ratio from remaining storage (capacity - occupancy)
+//   4. per-edge move ratios and flow; exiting stock leaves the network and
+//      is not throttled by the destination's capacity
+// The (destination, type) breakdown is sparse: one FlowStock entry per
+// node and commodity actually holding vehicles, moved by its edge's ratio.
+//
+// Memory: routing is dense, one next-hop edge per node for each distinct
+// destination seen (4 bytes * nodes * destinations; 500k nodes and 100
+// destinations take about 200 MB), so networks with very many
+// destinations are limited by the route tables.
+class FlowModel {
+public:
+    void build(const vector<NodeData>& nodes);
+
+    // Vehicles per second a node can discharge (the micro engine serves one
+    // vehicle per token cycle).
+    void set_service_rate(double vehicles_per_second) { service_rate = vehicles_per_second; }
+
+    // Stock added at its own destination completes immediately
+    void add_stock(int node, int destination, VehicleType type, double amount);
+    void add_vehicles_from_queues(const vector<NodeData>& nodes);
+
+    // Hybrid runs: external nodes belong to the vehicle engine. Stock that
+    // flows into one is held there without being forwarded and released as
+    // whole vehicles by take_boundary_vehicles; the fractional remainder
+    // stays behind, so stock + released + completed is conserved exactly.
+    // set_external_load reports the discrete vehicles already at a node so
+    // its receiving ratio sees the true remaining storage.
+    void set_external_nodes(const vector<bool>& external);
+    void set_external_load(size_t node, int vehicles) { external_load[node] = vehicles; }
+    template<class Emit>
+    void take_boundary_vehicles(Emit emit);
+
+    void step(double dt);
+
+    double total_stock() const;
+    double node_occupancy(size_t node) const { return occupancy[node]; }   // current stock at node
+    const FlowKpis& kpis() const { return totals; }
+
+    // Per-edge flow (vehicles moved in the last sweep) and density
+    // (vehicles routed onto the edge / storage capacity of its tail node).
+    size_t edge_count() const { return edge_to.size(); }
+    int edge_source(size_t edge) const { return edge_from[edge]; }
+    int edge_target(size_t edge) const { return edge_to[edge]; }
+    const vector<double>& edge_flows() const { return edge_flow; }
+    vector<double> edge_densities() const;
+
+    // Adds totals into the shared SystemStats KPIs (rounded to vehicles).
+    void export_stats(SystemStats& stats) const;
+
+private:
+    struct FlowStock {
+        uint32_t route;         // destination slot
+        VehicleType type;
+        double amount;
+    };
+    struct FlowTransfer {
+        int node;
+        FlowStock stock;
+    };
+
+    uint32_t route_for(int destination);
+    void compute_routes(uint32_t route);
+    int route_edge(uint32_t route, size_t node) const { return route_edges[route * node_count + node]; }
+    void deposit(int node, const FlowStock& stock);
+    void add_edge_stock(int node, const FlowStock& stock, double amount);
+    void complete(const FlowStock& stock, double amount);
+
+    size_t node_count = 0;
+    double service_rate = 2.0;
+
+    // Graph (CSR)
+    vector<int> capacity;
+    vector<bool> external;
+    vector<int> external_load;
+    vector<int> edge_offset;
+    vector<int> edge_from;
+    vector<int> edge_to;
+    vector<vector<int>> reverse_adjacency;
+
+    // Routes, one slot per destination
+    unordered_map<int, uint32_t> route_index;
+    vector<int> route_destination;
+    vector<int> route_edges;            // [route * n + i], -1 when no route
+
+    // Per-edge state (SoA)
+    vector<double> edge_through;        // stock routed over the edge and beyond
+    vector<double> edge_exit;           // stock leaving the network at the head
+    vector<double> edge_flow;
+
+    // Per-node state
+    vector<double> stranded;            // stock with no route to its destination
+    vector<double> occupancy;
+    vector<double> send_ratio;
+    vector<double> inflow_demand;
+    vector<double> accept_ratio;
+
+    // Destination breakdown
+    vector<vector<FlowStock>> stock;    // by node
+    vector<FlowTransfer> transfers;     // scratch for one sweep
+    FlowKpis totals;
+};
+
+template<class Emit>
+void FlowModel::take_boundary_vehicles(Emit emit) {
+    // emit(node, destination, type, count) receives whole vehicles only
+    for (size_t i = 0; i < node_count; ++i) {
+        if (!external[i]) continue;
+        for (FlowStock& entry : stock[i]) {
+            int whole = static_cast<int>(entry.amount + 1e-9);
+            if (whole < 1) continue;
+            entry.amount -= whole;
+            add_edge_stock(static_cast<int>(i), entry, -whole);
+            occupancy[i] -= whole;
+            emit(static_cast<int>(i), route_destination[entry.route], entry.type, whole);
+        }
+    }
+}
+
+#endif // FLOW_MODEL_H
@@ -0,0 +1,94 @@
+#ifndef MAP_MATCHING_H
+#define MAP_MATCHING_H
+
+#include "data_structures.h"
+#include "spatial_index.h"
+#include "thread_pool.h"
+#include <vector>
+#include <string>
+#include <mutex>
+#include <memory>
+
+using namespace std;
+
+// ================================
+// GPS TRACES AND TRIPS
+// ================================
+
+struct GpsPing {
+    double timestamp;
+    GeoPoint position;      // same convention as the spatial index
+};
+
+struct GpsTrace {
+    int trace_id;
+    vector<GpsPing> pings;  // sorted by timestamp
+};
+
+// Connected node sequence the simulator can replay as Vehicle::path.
+struct MatchedTrip {
+    int trace_id = -1;
+    vector<int> nodes;
+    size_t matched_pings = 0;   // pings that had at least one candidate
+    size_t breaks = 0;          // HMM restarts where no transition was feasible
+};
+
+// Distances are in spatial index units (planar units or kilometres).
+// Zero picks a value from the mean edge length of the network.
+struct MapMatchParams {
+    double gps_sigma = 0.0;         // emission noise
+    double search_radius = 0.0;     // candidates farther than this are ignored
+    double transition_beta = 0.0;   // route vs straight-line mismatch scale
+    double max_route = 0.0;         // longer transitions count as infeasible
+    size_t max_candidates = 4;
+};
+
+// ================================
+// HMM MAP MATCHER
+// ================================
+
+// Candidates for each ping are its nearest nodes from the spatial index.
+// Emissions are Gaussian in the snap distance; transitions penalise the gap
+// between the network route and the straight line between pings. Viterbi
+// picks the most likely candidate per ping and the picks are joined with
+// shortest routes. Shortest-path rows are bounded by max_route, computed
+// once per source node on first use and shared by every trace and thread.
+class MapMatcher {
+public:
+    MapMatcher(const vector<NodeData>& nodes, const SpatialIndex& index, const MapMatchParams& params);
+
+    MatchedTrip match(const GpsTrace& trace) const;
+    void match_all(const vector<GpsTrace>& traces, vector<MatchedTrip>& trips, ThreadPool& pool) const;
+
+    // "trace_id timestamp a b" per line, commas allowed; a, b are x, y or
+    // lat, lon when geographic. Lines starting with '#' are skipped.
+    static bool load_traces(const string& path, bool geographic, vector<GpsTrace>& traces);
+    // "trace_id: A B C ..." per trip
+    static bool save_trips(const string& path, const vector<MatchedTrip>& trips);
+
+    const MapMatchParams& parameters() const { return params; }
+
+private:
+    // Nodes within max_route of the source, sorted by node id
+    struct RouteRow {
+        vector<int> node;
+        vector<float> distance;
+        vector<int> parent;         // predecessor on the shortest route
+    };
+
+    const RouteRow& route_from(int source) const;
+    static int row_slot(const RouteRow& row, int target);
+    void append_route(int from, int to, vector<int>& out) const;
+
+    const SpatialIndex& index;
+    MapMatchParams params;
+    size_t node_count;
+    vector<uint32_t> adjacency_start;   // CSR over nodes[i].adjacent_nodes
+    vector<int> adjacency;
+    vector<float> edge_length;
+
+    mutable unique_ptr<once_flag[]> row_ready;
+    mutable vector<RouteRow> rows;
+};
+
+#endif // MAP_MATCHING_H
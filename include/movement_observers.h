@@ -0,0 +1,80 @@
+#ifndef MOVEMENT_OBSERVERS_H
+#define MOVEMENT_OBSERVERS_H
+
+#include "data_structures.h"
+
+using namespace std;
+
+// ================================
+// MOVEMENT OBSERVER POLICIES
+// ================================
+
+// The movement engine (TrafficNetwork::process_vehicle / perform_vehicle_move)
+// is templated on one of these policies. Every hook receives node indices and
+// the vehicle involved; the engine never branches on the display mode itself.
+
+// Headless policy for AUTOMATIC, FAST_RUN and batch runs. All hooks are empty
+// inline functions, so the instantiated engine contains no display work.
+struct SilentMovementObserver {
+    void on_vehicle_selected(const Vehicle&, size_t) {}
+    void on_no_path(const Vehicle&, size_t) {}
+    void on_blocked(const Vehicle&, int) {}
+    void on_red_signal(const Vehicle&, int) {}
+    void on_move(const Vehicle&, size_t, int) {}
+    void on_destination_reached(const Vehicle&) {}
+    void on_enqueued(const Vehicle&, int) {}
+    void on_bounced(const Vehicle&, size_t) {}
+};
+
+// STEP_BY_STEP policy: narrates each decision to the terminal.
+struct NarratingMovementObserver {
+    void on_vehicle_selected(const Vehicle& vehicle, size_t node);
+    void on_no_path(const Vehicle& vehicle, size_t node);
+    void on_blocked(const Vehicle& vehicle, int next_node);
+    void on_red_signal(const Vehicle& vehicle, int next_node);
+    void on_move(const Vehicle& vehicle, size_t from_node, int to_node);
+    void on_destination_reached(const Vehicle& vehicle);
+    void on_enqueued(const Vehicle& vehicle, int node);
+    void on_bounced(const Vehicle& vehicle, size_t node);
+};
+
+struct MovementEvent {
+    MovementEventKind kind;
+    int vehicle_id;
+    int from_node;
+    int to_node;
+
+    bool operator==(const MovementEvent& other) const {
+        return kind == other.kind && vehicle_id == other.vehicle_id &&
+               from_node == other.from_node && to_node == other.to_node;
+    }
+    bool operator!=(const MovementEvent& other) const { return !(*this == other); }
+};
+
+// DIFFERENTIAL_CHECK policy: appends every outcome to an event trace.
+struct RecordingMovementObserver {
+    vector<MovementEvent>& events;
+
+    void on_vehicle_selected(const Vehicle&, size_t) {}
+    void on_no_path(const Vehicle& vehicle, size_t node) {
+        events.push_back({MovementEventKind::NO_PATH, vehicle.vehicle_id, static_cast<int>(node), -1});
+    }
+    void on_blocked(const Vehicle& vehicle, int next_node) {
+        events.push_back({MovementEventKind::BLOCKED, vehicle.vehicle_id, vehicle.current_node, next_node});
+    }
+    void on_red_signal(const Vehicle& vehicle, int next_node) {
+        events.push_back({MovementEventKind::RED_SIGNAL, vehicle.vehicle_id, vehicle.current_node, next_node});
+    }
+    void on_move(const Vehicle& vehicle, size_t from_node, int to_node) {
+        events.push_back({MovementEventKind::MOVE, vehicle.vehicle_id, static_cast<int>(from_node), to_node});
+    }
+    void on_destination_reached(const Vehicle& vehicle) {
+        events.push_back({MovementEventKind::ARRIVE, vehicle.vehicle_id, vehicle.current_node, -1});
+    }
+    void on_enqueued(const Vehicle&, int) {}
+    void on_bounced(const Vehicle& vehicle, size_t node) {
+        events.push_back({MovementEventKind::BOUNCED, vehicle.vehicle_id, static_cast<int>(node), -1});
+    }
+};
+
+#endif // MOVEMENT_OBSERVERS_H
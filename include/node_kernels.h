@@ -0,0 +1,85 @@
+#ifndef NODE_KERNELS_H
+#define NODE_KERNELS_H
+
+#include "types.h"
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// FIRST-TOUCH ARRAYS
+// ================================
+
+// resize() leaves elements uninitialized, so a fresh array's pages are placed
+// on the NUMA node of whichever thread writes them first, not the allocator's.
+template<class T>
+struct FirstTouchAllocator : allocator<T> {
+    template<class U> struct rebind { using other = FirstTouchAllocator<U>; };
+    FirstTouchAllocator() = default;
+    template<class U> FirstTouchAllocator(const FirstTouchAllocator<U>&) noexcept {}
+
+    template<class U> void construct(U* p) noexcept { ::new (static_cast<void*>(p)) U; }
+    template<class U, class... Args> void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(forward<Args>(args)...);
+    }
+};
+
+template<class T>
+using node_array = vector<T, FirstTouchAllocator<T>>;
+
+// ================================
+// STRUCTURE-OF-ARRAYS NODE STATE
+// ================================
+
+// Per-tick snapshot of node counters laid out for vectorized scans. Inputs are
+// gathered from NodeData each tick; outputs are written by the kernels.
+// resize() does not write the arrays: the first full refresh fills every
+// block, and with pinned workers each block's owner fills it.
+struct NodeStateArrays {
+    // Inputs
+    node_array<int32_t> current_vehicles;
+    node_array<int32_t> capacity;
+    node_array<int32_t> waiting;
+    node_array<int32_t> emergency;
+
+    // Outputs
+    node_array<float> utilization;       // percent of capacity
+    node_array<uint8_t> status;          // NodeStatus
+    node_array<int32_t> headroom;        // capacity - current_vehicles
+    node_array<uint64_t> work_mask;      // bit i: node i has queued vehicles
+    node_array<uint64_t> emergency_mask; // bit i: node i has queued emergency vehicles
+
+    void resize(size_t n);
+    size_t size() const { return capacity.size(); }
+    bool has_work(size_t i) const { return (work_mask[i >> 6] >> (i & 63)) & 1; }
+};
+
+// ================================
+// NODE STATE KERNELS
+// ================================
+
+namespace NodeKernels {
+    // Number of nodes covered by one mask word; parallel callers must split
+    // ranges on multiples of this so chunks never share a mask word.
+    constexpr size_t BLOCK = 64;
+
+    // Computes every output for nodes [begin, end) using the best kernel the
+    // CPU supports. begin must be a multiple of BLOCK.
+    void update(NodeStateArrays& state, size_t begin, size_t end);
+    void update(NodeStateArrays& state);
+
+    void update_scalar(NodeStateArrays& state, size_t begin, size_t end);
+
+    bool avx2_available();
+    const char* active_kernel_name();
+
+    NodeStatus classify(int current, int capacity);
+    const char* status_name(NodeStatus status);
+}
+
+#endif // NODE_KERNELS_H
@@ -0,0 +1,168 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+using namespace std;
+
+// ================================
+// COUNTER-BASED RANDOM NUMBERS
+// ================================
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2,
+// 3"). A draw is a pure function of the seed and a 128-bit counter built
+// from (stream, tick, purpose, block), so any thread can produce any
+// vehicle's numbers for any tick in any order and get the same values.
+// Streams are usually vehicle or node ids; purposes keep decisions about
+// the same vehicle and tick independent of each other.
+
+enum class RandomPurpose : uint32_t {
+    SAMPLE_VEHICLES = 1,
+    DEMAND,
+    TRAVEL_TIME,
+    SERVICE_TIME,
+    ROUTE_CHOICE,
+    ENV_ARRIVALS,
+    ENV_ACTIONS,
+    SCENARIO,
+    TRACE
+};
+
+struct PhiloxBlock {
+    uint32_t v[4];
+};
+
+namespace PhiloxDetail {
+    constexpr uint32_t M0 = 0xD2511F53u;
+    constexpr uint32_t M1 = 0xCD9E8D57u;
+    constexpr uint32_t W0 = 0x9E3779B9u;
+    constexpr uint32_t W1 = 0xBB67AE85u;
+    constexpr double INV_2_32 = 1.0 / 4294967296.0;
+
+    inline void round(uint32_t& c0, uint32_t& c1, uint32_t& c2, uint32_t& c3, uint32_t k0, uint32_t k1) {
+        uint64_t p0 = static_cast<uint64_t>(M0) * c0;
+        uint64_t p1 = static_cast<uint64_t>(M1) * c2;
+        uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        c1 = static_cast<uint32_t>(p1);
+        c3 = static_cast<uint32_t>(p0);
+        c0 = n0;
+        c2 = n2;
+    }
+
+    inline PhiloxBlock philox4x32_10(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3,
+                                     uint32_t k0, uint32_t k1) {
+        for (int r = 0; r < 10; ++r) {
+            round(c0, c1, c2, c3, k0, k1);
+            k0 += W0;
+            k1 += W1;
+        }
+        return PhiloxBlock{{c0, c1, c2, c3}};
+    }
+
+    // Open interval (0, 1): safe for log() in inverse-CDF samplers
+    inline double to_open_unit(uint32_t x) {
+        return (static_cast<double>(x) + 0.5) * INV_2_32;
+    }
+}
+
+class CounterRng {
+public:
+    explicit CounterRng(uint64_t seed = 1)
+        : k0(static_cast<uint32_t>(seed)), k1(static_cast<uint32_t>(seed >> 32)) {}
+
+    // Four words per (stream, tick, purpose, block)
+    PhiloxBlock draw(uint32_t stream, uint32_t tick, RandomPurpose purpose, uint32_t block = 0) const {
+        return PhiloxDetail::philox4x32_10(block, tick, stream, static_cast<uint32_t>(purpose), k0, k1);
+    }
+
+    // Word `index` of the key's sequence: word index % 4 of block index / 4
+    uint32_t bits(uint32_t stream, uint32_t tick, RandomPurpose purpose, uint32_t index = 0) const {
+        return draw(stream, tick, purpose, index / 4).v[index % 4];
+    }
+
+    double uniform(uint32_t stream, uint32_t tick, RandomPurpose purpose, uint32_t index = 0) const {
+        return PhiloxDetail::to_open_unit(bits(stream, tick, purpose, index));
+    }
+
+    // [0, bound), multiply-shift (bias below 2^-32 * bound)
+    uint32_t below(uint32_t bound, uint32_t stream, uint32_t tick, RandomPurpose purpose,
+                   uint32_t index = 0) const {
+        return static_cast<uint32_t>((static_cast<uint64_t>(bits(stream, tick, purpose, index)) * bound) >> 32);
+    }
+
+    // out[i] = uniform(stream, tick, purpose, i)
+    void fill_uniform(uint32_t stream, uint32_t tick, RandomPurpose purpose, double* out, size_t n) const {
+        size_t blocks = n / 4;
+        for (size_t b = 0; b < blocks; ++b) {
+            PhiloxBlock block = draw(stream, tick, purpose, static_cast<uint32_t>(b));
+            for (int w = 0; w < 4; ++w) out[4 * b + w] = PhiloxDetail::to_open_unit(block.v[w]);
+        }
+        for (size_t i = 4 * blocks; i < n; ++i) out[i] = uniform(stream, tick, purpose, static_cast<uint32_t>(i));
+    }
+
+    // out[i] = uniform(streams[i], tick, purpose, 0). Lanes are processed in
+    // structure-of-arrays groups so the rounds vectorize.
+    void fill_uniform(const uint32_t* streams, size_t n, uint32_t tick, RandomPurpose purpose, double* out) const {
+        constexpr size_t LANES = 8;
+        const uint32_t c3 = static_cast<uint32_t>(purpose);
+        size_t i = 0;
+        for (; i + LANES <= n; i += LANES) {
+            uint32_t c0[LANES], c1[LANES], c2[LANES], c3v[LANES];
+            for (size_t l = 0; l < LANES; ++l) {
+                c0[l] = 0;
+                c1[l] = tick;
+                c2[l] = streams[i + l];
+                c3v[l] = c3;
+            }
+            uint32_t a = k0, b = k1;
+            for (int r = 0; r < 10; ++r) {
+                for (size_t l = 0; l < LANES; ++l) {
+                    PhiloxDetail::round(c0[l], c1[l], c2[l], c3v[l], a, b);
+                }
+                a += PhiloxDetail::W0;
+                b += PhiloxDetail::W1;
+            }
+            for (size_t l = 0; l < LANES; ++l) out[i + l] = PhiloxDetail::to_open_unit(c0[l]);
+        }
+        for (; i < n; ++i) out[i] = uniform(streams[i], tick, purpose, 0);
+    }
+
+private:
+    uint32_t k0;
+    uint32_t k1;
+};
+
+// UniformRandomBitGenerator over one (stream, tick, purpose) key, for use
+// with <random> distributions. Successive calls walk the block counter.
+class PhiloxEngine {
+public:
+    using result_type = uint32_t;
+
+    PhiloxEngine(uint64_t seed, uint32_t stream, RandomPurpose purpose, uint32_t tick = 0)
+        : rng(seed), stream(stream), tick(tick), purpose(purpose) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return numeric_limits<uint32_t>::max(); }
+
+    result_type operator()() {
+        if (lane == 4) {
+            buffer = rng.draw(stream, tick, purpose, next_block++);
+            lane = 0;
+        }
+        return buffer.v[lane++];
+    }
+
+private:
+    CounterRng rng;
+    uint32_t stream;
+    uint32_t tick;
+    RandomPurpose purpose;
+    uint32_t next_block = 0;
+    PhiloxBlock buffer{};
+    int lane = 4;
+};
+
+#endif // PHILOX_H
@@ -0,0 +1,89 @@
+#ifndef REFERENCE_ENGINE_H
+#define REFERENCE_ENGINE_H
+
+#include "types.h"
+#include "movement_observers.h"
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+// ================================
+// DIFFERENTIAL SCENARIOS
+// ================================
+
+struct ScenarioVehicle {
+    int vehicle_id;
+    VehicleType type;
+    int source;
+    int destination;
+};
+
+// Small random network with every node at or below capacity. No traffic
+// controllers: signal policies are not part of the reference semantics.
+struct DifferentialScenario {
+    uint64_t seed = 0;
+    vector<vector<int>> adjacency;      // out-neighbours in matrix order
+    vector<int> capacity;
+    vector<ScenarioVehicle> vehicles;   // queue order per node
+
+    static DifferentialScenario random(uint64_t seed);
+};
+
+// ================================
+// SEQUENTIAL REFERENCE ENGINE
+// ================================
+
+// Straight-line restatement of the token tick with no threads, no shared
+// state and no shortcuts, used as the oracle for the production engine.
+// One tick visits every node that had vehicles when the tick began, in
+// index order, and serves the head vehicle:
+//   - emergency vehicles first (ambulance, then fire truck, then oldest)
+//   - next hop is the BFS first hop in adjacency order; the destination
+//     itself if adjacent; the first neighbour if unreachable
+//   - the move needs room: occupancy < capacity, +1 for emergencies
+//   - a blocked vehicle goes back to its queue; every sixth consecutive
+//     block counts a rerouting attempt
+class ReferenceEngine {
+public:
+    explicit ReferenceEngine(const DifferentialScenario& scenario);
+
+    void tick(vector<MovementEvent>& events);
+
+    size_t node_count() const { return capacity.size(); }
+    int occupancy_at(size_t node) const { return occupancy[node]; }
+    int queue_length(size_t node) const {
+        return static_cast<int>(waiting[node].size() + emergency[node].size());
+    }
+    size_t completed() const { return completed_count; }
+    size_t rerouting_attempts() const { return reroutes; }
+    size_t in_network() const { return total_vehicles - completed_count; }
+
+    // Empty when every invariant holds, otherwise the first violation
+    string check_invariants() const;
+
+private:
+    struct Car {
+        int vehicle_id;
+        VehicleType type;
+        int destination;
+        int blocked_attempts;
+    };
+
+    int first_hop(int from, int destination) const;
+    void push(int node, const Car& car);
+    Car pop(int node);
+
+    vector<vector<int>> adjacency;
+    vector<int> capacity;
+    vector<int> occupancy;
+    vector<deque<Car>> waiting;
+    vector<vector<Car>> emergency;      // kept sorted, served from the front
+    size_t total_vehicles = 0;
+    size_t completed_count = 0;
+    size_t reroutes = 0;
+};
+
+#endif // REFERENCE_ENGINE_H
@@ -0,0 +1,111 @@
+#ifndef SIGNAL_CONTROL_H
+#define SIGNAL_CONTROL_H
+
+#include "data_structures.h"
+#include "node_kernels.h"
+#include "thread_pool.h"
+#include <vector>
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// FIXED-TIME SIGNAL PLANS
+// ================================
+
+// Each controller cycles through its phases in table order, holding phase p
+// green for green_ticks[p] ticks; offset shifts where in the cycle tick 0 falls.
+struct SignalPlan {
+    vector<int> green_ticks;   // per phase, SignalController phase order
+    vector<int> offset;        // per controller
+};
+
+// ================================
+// MAX-PRESSURE SIGNAL CONTROL
+// ================================
+
+// One phase per inbound approach of every TRAFFIC_CONTROLLER node: phase u
+// of controller i gives green to vehicles entering i from u. A phase owns one
+// movement u -> i -> j per exit j of i (j != u), and its pressure is the
+// approach queue minus the mean downstream queue over those movements.
+// Each tick every controller switches to the phase with the highest pressure
+// among approaches whose head vehicle is waiting to enter it. Only
+// controllers with an approach or exit in a touched node block are
+// re-evaluated; the rest would pick the same phase again.
+//
+// Controllers, phases and movements live in flat CSR arrays ordered by
+// controller, so a contiguous range of controllers maps to contiguous
+// movement rows and controllers can be split across workers directly.
+class SignalController {
+public:
+    static constexpr int NO_PHASE = -1;
+
+    void build(const vector<NodeData>& nodes);
+
+    // queue lengths come from state.waiting + state.emergency; head_hop[u]
+    // is the next hop of the vehicle at the front of u's queue (-1 if none).
+    void update(const NodeStateArrays& state, const vector<int>& head_hop, ThreadPool& pool);
+
+    // Marks node's block for the next update: its queue or head hop changed
+    void touch(size_t node) {
+        size_t block = node / NodeKernels::BLOCK;
+        if (block < block_dirty.size() && !block_dirty[block]) {
+            block_dirty[block] = 1;
+            dirty_blocks.push_back(static_cast<uint32_t>(block));
+        }
+    }
+
+    // False only when to_node is a controller showing red to from_node.
+    bool allows(size_t from_node, int to_node) const {
+        int c = controller_of_node[to_node];
+        return c < 0 || green_approach[c] == NO_PHASE ||
+               green_approach[c] == static_cast<int>(from_node);
+    }
+
+    // Fixed-time operation (SIGNAL_CONTROL: FIXED_PLAN and the optimizer)
+    SignalPlan default_plan(int green_ticks) const;
+    int cycle_length(const SignalPlan& plan, size_t controller) const;
+    int plan_green_at(const SignalPlan& plan, size_t controller, size_t tick) const;
+    void apply_plan(const SignalPlan& plan, size_t tick);
+    bool save_plan(const string& path, const SignalPlan& plan) const;
+    bool load_plan(const string& path, SignalPlan& plan) const;
+
+    size_t controller_count() const { return controller_node.size(); }
+    size_t phase_count() const { return phase_approach.size(); }
+    size_t movement_count() const { return movement_out.size(); }
+    int controller_node_at(size_t controller) const { return controller_node[controller]; }
+    int controller_of(size_t node) const { return controller_of_node[node]; }
+    int phase_begin(size_t controller) const { return phase_offset[controller]; }
+    int phase_end(size_t controller) const { return phase_offset[controller + 1]; }
+    int phase_approach_at(size_t phase) const { return phase_approach[phase]; }
+    int green_for(size_t controller) const { return green_approach[controller]; }
+    size_t phase_switches() const { return switches; }
+
+private:
+    void update_range(size_t begin, size_t end, const vector<int>& head_hop);
+
+    vector<int> controller_of_node;   // -1 for plain wait nodes
+    vector<int> controller_node;
+    vector<int> phase_offset;         // [controller] -> first phase, size C + 1
+    vector<int> phase_approach;       // upstream node served by each phase
+    vector<int> movement_offset;      // [phase] -> first movement, size P + 1
+    vector<int> movement_out;         // exit node of each movement
+
+    vector<float> queue_length;       // per node, gathered each update
+    vector<float> phase_pressure;
+    vector<int> green_approach;       // per controller, NO_PHASE until first demand
+    vector<int> switched;             // per controller, 1 when the last update changed phase
+    size_t switches = 0;
+
+    // Controllers reading any node of a block, CSR over NodeKernels::BLOCK
+    vector<int> block_offset;
+    vector<int> block_controllers;
+    vector<uint8_t> block_dirty;
+    vector<uint32_t> dirty_blocks;
+    vector<uint8_t> controller_due;
+    vector<uint32_t> due_controllers;
+    bool full_update = true;
+};
+
+#endif // SIGNAL_CONTROL_H
@@ -0,0 +1,57 @@
+#ifndef SIGNAL_OPTIMIZER_H
+#define SIGNAL_OPTIMIZER_H
+
+#include "fast_forward.h"
+#include "signal_control.h"
+#include "thread_pool.h"
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// OFFLINE SIGNAL PLAN OPTIMIZER
+// ================================
+
+struct SignalOptimizerResult {
+    SignalPlan plan;
+    double cost = 0.0;
+    double initial_cost = 0.0;
+    double uncontrolled_cost = 0.0;   // every approach open, for reference
+    size_t evaluations = 0;
+    size_t rounds = 0;
+};
+
+// Steepest-descent coordinate search over fixed-time plans. Each round
+// scores every single-variable move (one phase's green time or one
+// controller's offset, +/-1 tick) with a fast-forward run from the loaded
+// state and takes the best improving move; it stops at a local optimum or
+// after max_rounds. Moves are scored in parallel: each pool chunk owns one
+// simulator and one copy of the plan, and the snapshot is shared read-only.
+class SignalOptimizer {
+public:
+    SignalOptimizer(const NetworkSnapshot& network, ThreadPool& pool);
+
+    SignalOptimizerResult optimize(const SignalPlan& start, size_t horizon_ticks,
+                                   size_t max_rounds, int max_green_ticks);
+
+private:
+    struct Move {
+        bool is_offset;
+        int index;    // phase for green time, controller for offset
+        int delta;
+    };
+
+    void build_moves(const SignalPlan& plan, int max_green_ticks);
+    void score_moves(const SignalPlan& plan, size_t horizon_ticks);
+    static void apply_move(SignalPlan& plan, const Move& move, const vector<int>& cycle);
+
+    const NetworkSnapshot& net;
+    ThreadPool& pool;
+
+    vector<Move> moves;
+    vector<double> move_cost;
+    vector<int> cycle_length;   // per controller, for wrapping offsets
+};
+
+#endif // SIGNAL_OPTIMIZER_H
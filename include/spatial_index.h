@@ -0,0 +1,63 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// SPATIAL GRID INDEX
+// ================================
+
+// Planar x/y, or longitude/latitude in degrees for geographic networks.
+struct GeoPoint {
+    double x;
+    double y;
+};
+
+// Packed uniform grid over node positions. Points are sorted by cell into
+// one contiguous array with a CSR cell table, sized for about two points
+// per cell, so nearest and range queries touch a handful of cache lines.
+// Distances are Euclidean for planar input and haversine kilometres for
+// geographic input; both are exact lower bounds on any path between two
+// nodes whose edges are as long as their straight-line distance.
+class SpatialIndex {
+public:
+    void build(const vector<GeoPoint>& points, bool geographic);
+    bool empty() const { return point_count == 0; }
+    bool is_geographic() const { return geographic; }
+
+    double distance(const GeoPoint& a, const GeoPoint& b) const;
+    double distance_between(int a, int b) const { return distance(position[a], position[b]); }
+    const GeoPoint& position_of(int point) const { return position[point]; }
+
+    // Nearest point to p, -1 if the index is empty
+    int nearest(const GeoPoint& p) const;
+    // Every point within radius of p, appended to out unordered
+    void within(const GeoPoint& p, double radius, vector<int>& out) const;
+    // Up to k nearest points, closest first
+    void k_nearest(const GeoPoint& p, size_t k, vector<int>& out) const;
+
+private:
+    int cell_x(double x) const;
+    int cell_y(double y) const;
+    // Lower bound on the distance from p to anything r or more rings out
+    double ring_bound(int rings) const;
+
+    bool geographic = false;
+    size_t point_count = 0;
+    vector<GeoPoint> position;     // by point id
+
+    double min_x = 0.0, min_y = 0.0;
+    double cell_size = 1.0;
+    double x_scale = 1.0;          // distance units per coordinate unit along x
+    double y_scale = 1.0;
+    int grid_w = 1, grid_h = 1;
+    vector<uint32_t> cell_start;   // size grid_w * grid_h + 1
+    vector<int> cell_points;       // point ids sorted by cell
+    vector<GeoPoint> cell_coords;  // positions in the same order
+};
+
+#endif // SPATIAL_INDEX_H
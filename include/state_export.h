@@ -0,0 +1,110 @@
+#ifndef STATE_EXPORT_H
+#define STATE_EXPORT_H
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+using namespace std;
+
+// ================================
+// SHARED-MEMORY STATE LAYOUT
+// ================================
+
+// POSIX shared-memory object, laid out as:
+//   SharedStateHeader
+//   edge table: int32 (from, to) per edge, written once at open
+//   frame 0, frame 1: SharedFrameHeader, int32 occupancy[n],
+//                     int32 queue_depth[n], float edge_flow[e]
+// The writer fills the frame that is not `front`, then flips `front`. Each
+// frame has its own sequence counter (odd while being written), so a reader
+// copies the front frame and retries if that frame's sequence moved.
+namespace SharedStateLayout {
+    constexpr uint32_t MAGIC = 0x54524146;   // "TRAF"
+    constexpr uint32_t VERSION = 1;
+}
+
+struct SharedStateHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t node_count;
+    uint32_t edge_count;
+    uint64_t edges_offset;
+    uint64_t frame_offset[2];
+    uint64_t frame_bytes;
+    atomic<uint32_t> front;
+    atomic<uint64_t> frame_sequence[2];
+};
+
+struct SharedFrameHeader {
+    uint64_t tick;
+    double simulated_seconds;
+};
+
+// Pointers into the frame being written; fill them, then end_frame().
+struct SharedFrame {
+    int32_t* occupancy;
+    int32_t* queue_depth;
+    float* edge_flow;
+};
+
+// ================================
+// WRITER
+// ================================
+
+class SharedStateExporter {
+public:
+    ~SharedStateExporter() { close(); }
+
+    // name is a POSIX shm name such as "/traffic_state". Replaces any
+    // existing object of that name. Returns false when shared memory is
+    // unavailable on this platform or the mapping fails.
+    bool open(const string& name, size_t node_count, const vector<pair<int, int>>& edges);
+    void close();
+    bool is_open() const { return base != nullptr; }
+
+    SharedFrame begin_frame(uint64_t tick, double simulated_seconds);
+    void end_frame();
+
+private:
+    SharedFrame frame_at(uint32_t index) const;
+
+    string shm_name;
+    char* base = nullptr;
+    size_t mapped_bytes = 0;
+    uint32_t writing = 0;
+};
+
+// ================================
+// READER
+// ================================
+
+// For viewers in other processes: maps the object read-only and copies out
+// the latest complete frame.
+class SharedStateReader {
+public:
+    ~SharedStateReader() { close(); }
+
+    bool open(const string& name);
+    void close();
+
+    size_t node_count() const;
+    size_t edge_count() const;
+    pair<int, int> edge(size_t e) const;
+
+    // Returns false if no frame has been published yet, or if no consistent
+    // frame could be read within READ_ATTEMPTS tries.
+    bool read_latest(SharedFrameHeader& header, vector<int32_t>& occupancy,
+                     vector<int32_t>& queue_depth, vector<float>& edge_flow) const;
+
+    static constexpr int READ_ATTEMPTS = 1000;
+
+private:
+    const char* base = nullptr;
+    size_t mapped_bytes = 0;
+};
+
+#endif // STATE_EXPORT_H
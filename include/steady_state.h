@@ -0,0 +1,49 @@
+#ifndef STEADY_STATE_H
+#define STEADY_STATE_H
+
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// STEADY-STATE DETECTION
+// ================================
+
+struct SteadyStateResult {
+    bool steady = false;
+    size_t warmup = 0;          // observations discarded as warm-up
+    size_t batches = 0;         // batch means behind the interval
+    double mean = 0.0;
+    double half_width = 0.0;    // 95% confidence half-width
+};
+
+// Fixed-interval KPI observations (e.g. moves per second over each token
+// cycle). The warm-up is cut with MSER-5: observations are averaged in
+// groups of five and the truncation point minimizing the marginal standard
+// error of the remainder is chosen from the first half of the run. The
+// remainder is split into batch means, and the run counts as steady once
+// the 95% confidence half-width is within `precision` of the mean. A
+// truncation point at the end of the searched half means the series is
+// still trending, so it is never reported steady. A series that is
+// constant (gridlock included) is steady as soon as it has enough batches.
+class SteadyStateDetector {
+public:
+    explicit SteadyStateDetector(double precision = 0.05, size_t batch_count = 10);
+
+    void add(double observation) { observations.push_back(observation); }
+    void clear() { observations.clear(); }
+    size_t size() const { return observations.size(); }
+
+    // O(n) in the observations so far
+    SteadyStateResult evaluate() const;
+
+    static constexpr size_t MSER_GROUP = 5;
+
+private:
+    double precision;
+    size_t batch_count;
+    vector<double> observations;
+};
+
+#endif // STEADY_STATE_H
@@ -0,0 +1,96 @@
+#ifndef STOP_TOKEN_H
+#define STOP_TOKEN_H
+
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+// ================================
+// COOPERATIVE CANCELLATION
+// ================================
+
+// Minimal C++17 stand-in for std::stop_source/std::stop_token. Loops poll
+// stop_requested() and replace raw sleep_for with wait_for(), which returns
+// as soon as a stop is requested instead of sleeping out the full interval.
+class StopToken {
+public:
+    StopToken() = default;
+
+    bool stop_requested() const { return state && state->stopped.load(); }
+
+    // Sleeps for up to `timeout`; returns true if a stop was requested.
+    template<class Rep, class Period>
+    bool wait_for(const chrono::duration<Rep, Period>& timeout) const;
+
+    // Runs `callback` once when a stop is requested (immediately if it already
+    // was). Used to wake waits that block on other condition variables.
+    void on_stop(function<void()> callback) const;
+
+private:
+    friend class StopSource;
+
+    struct State {
+        atomic<bool> stopped{false};
+        mutex wait_mutex;
+        condition_variable wait_cv;
+        vector<function<void()>> callbacks;
+    };
+
+    explicit StopToken(shared_ptr<State> s) : state(move(s)) {}
+    shared_ptr<State> state;
+};
+
+class StopSource {
+public:
+    StopSource() : state(make_shared<StopToken::State>()) {}
+
+    StopToken get_token() const { return StopToken(state); }
+    bool stop_requested() const { return state->stopped.load(); }
+
+    // Returns false if a stop had already been requested.
+    bool request_stop();
+
+private:
+    shared_ptr<StopToken::State> state;
+};
+
+template<class Rep, class Period>
+bool StopToken::wait_for(const chrono::duration<Rep, Period>& timeout) const {
+    if (!state) return false;
+    unique_lock<mutex> lock(state->wait_mutex);
+    return state->wait_cv.wait_for(lock, timeout, [this]() { return state->stopped.load(); });
+}
+
+inline void StopToken::on_stop(function<void()> callback) const {
+    if (!state) return;
+    {
+        lock_guard<mutex> lock(state->wait_mutex);
+        if (!state->stopped.load()) {
+            state->callbacks.push_back(move(callback));
+            return;
+        }
+    }
+    callback();
+}
+
+inline bool StopSource::request_stop() {
+    vector<function<void()>> callbacks;
+    {
+        lock_guard<mutex> lock(state->wait_mutex);
+        if (state->stopped.exchange(true)) return false;
+        callbacks.swap(state->callbacks);
+    }
+    state->wait_cv.notify_all();
+    for (auto& callback : callbacks) {
+        callback();
+    }
+    return true;
+}
+
+#endif // STOP_TOKEN_H
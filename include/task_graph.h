@@ -0,0 +1,67 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include "thread_pool.h"
+#include <vector>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <exception>
+
+using namespace std;
+
+// ================================
+// TASK GRAPH
+// ================================
+
+// Lightweight dependency graph executed on a ThreadPool. Tasks become ready
+// once all of their predecessors have finished; continuations added with
+// then() are ordinary tasks with a single predecessor.
+class TaskGraph {
+public:
+    using TaskId = size_t;
+
+    TaskId add_task(function<void()> work);
+    void precede(TaskId before, TaskId after);
+    TaskId then(TaskId before, function<void()> work);
+
+    // Submits every task with no predecessors. The graph may be run again
+    // once the previous run has completed.
+    void run(ThreadPool& pool);
+    void wait();
+    bool wait_until(chrono::steady_clock::time_point deadline);
+    bool wait_for(chrono::steady_clock::duration timeout);
+
+    size_t size() const { return tasks->size(); }
+    size_t completed() const;
+
+private:
+    struct Task {
+        function<void()> work;
+        vector<TaskId> successors;
+        int predecessor_count = 0;
+        atomic<int> pending{0};
+    };
+
+    struct RunState {
+        shared_ptr<vector<unique_ptr<Task>>> tasks;
+        ThreadPool* pool = nullptr;
+        atomic<size_t> remaining{0};
+        atomic<size_t> finished{0};
+        mutex done_mutex;
+        condition_variable done_cv;
+        exception_ptr error;
+    };
+
+    static void execute(const shared_ptr<RunState>& state, TaskId id);
+
+    // Shared with in-flight runs so a graph abandoned after a timed-out wait
+    // does not free tasks that are still queued on the pool.
+    shared_ptr<vector<unique_ptr<Task>>> tasks = make_shared<vector<unique_ptr<Task>>>();
+    shared_ptr<RunState> current_run;
+};
+
+#endif // TASK_GRAPH_H
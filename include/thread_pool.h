@@ -8,6 +8,10 @@
 #include <condition_variable>
 #include <future>
 #include <functional>
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <algorithm>
 
 using namespace std;
 
@@ -22,13 +26,44 @@ private:
     mutex queue_mutex;
     condition_variable condition;
     bool stop = false;
+    atomic<size_t> idle_workers{0};
+    vector<int> worker_cpus;
+    vector<queue<function<void()>>> worker_tasks;   // work only worker i may run
+    vector<uint8_t> worker_waiting;                 // guarded by queue_mutex
 
 public:
-    ThreadPool(size_t threads);
-    
+    // With pin_workers, worker i is bound to the i-th allowed CPU (wrapping
+    // around when there are more workers than CPUs).
+    ThreadPool(size_t threads, bool pin_workers = false);
+
     template<class F, class... Args>
     auto enqueue(F&& f, Args&&... args) -> future<typename result_of<F(Args...)>::type>;
-    
+
+    // Data-parallel loop over [begin, end). The range is split into chunks that
+    // workers claim dynamically; the calling thread claims chunks too, so the
+    // call completes even when every worker is busy with long-running tasks.
+    // body(chunk_begin, chunk_end) is invoked once per chunk.
+    template<class F>
+    void parallel_for_range(size_t begin, size_t end, F&& body, size_t min_grain = 1);
+
+    // Per-index convenience wrapper around parallel_for_range.
+    template<class F>
+    void parallel_for(size_t begin, size_t end, F&& body, size_t min_grain = 1);
+
+    // Static partition: [begin, end) splits into one range per worker, cut on
+    // multiples of align, and worker i always gets range i. A pinned worker
+    // therefore first-touches and keeps revisiting the same memory. Ranges of
+    // busy workers run on the caller instead of waiting for them.
+    template<class F>
+    void parallel_for_static(size_t begin, size_t end, F&& body, size_t align = 1);
+    pair<size_t, size_t> static_range(size_t part, size_t begin, size_t end, size_t align = 1) const;
+
+    size_t size() const { return workers.size(); }
+    bool is_pinned() const { return !worker_cpus.empty(); }
+
+    // NUMA node a pinned worker runs on; -1 for floating workers.
+    int worker_numa_node(size_t worker) const;
+
     ~ThreadPool();
 };
 
@@ -51,4 +86,150 @@ auto ThreadPool::enqueue(F&& f, Args&&... args) -> future<typename result_of<F(A
     return res;
 }
 
-#endif // THREAD_POOL_H
\ No newline at end of file
+template<class F>
+void ThreadPool::parallel_for_range(size_t begin, size_t end, F&& body, size_t min_grain) {
+    if (begin >= end) return;
+
+    size_t count = end - begin;
+    size_t participants = workers.size() + 1;
+
+    // Aim for ~4 chunks per participant so uneven chunks balance out, but never
+    // go below the caller's minimum grain.
+    size_t grain = max<size_t>(max<size_t>(min_grain, 1), count / (participants * 4));
+    size_t chunks = (count + grain - 1) / grain;
+
+    if (chunks <= 1 || workers.empty()) {
+        body(begin, end);
+        return;
+    }
+
+    // Shared state outlives the call: helpers that start after the caller has
+    // already finished every chunk find nothing left and exit.
+    struct LoopState {
+        atomic<size_t> next_chunk{0};
+        atomic<size_t> remaining;
+        mutex done_mutex;
+        condition_variable done_cv;
+        exception_ptr error;
+        mutex error_mutex;
+        explicit LoopState(size_t n) : remaining(n) {}
+    };
+    auto state = make_shared<LoopState>(chunks);
+
+    auto run_chunks = [state, begin, end, grain, chunks, &body]() {
+        for (;;) {
+            size_t chunk = state->next_chunk.fetch_add(1);
+            if (chunk >= chunks) return;
+            size_t lo = begin + chunk * grain;
+            size_t hi = min(end, lo + grain);
+            try {
+                body(lo, hi);
+            } catch (...) {
+                lock_guard<mutex> lock(state->error_mutex);
+                if (!state->error) state->error = current_exception();
+            }
+            if (state->remaining.fetch_sub(1) == 1) {
+                lock_guard<mutex> lock(state->done_mutex);
+                state->done_cv.notify_all();
+            }
+        }
+    };
+
+    // Only recruit workers that are actually idle; queuing helpers behind
+    // long-running tasks would just leave stale closures in the queue.
+    size_t helpers = min(idle_workers.load(), chunks - 1);
+    if (helpers > 0) {
+        unique_lock<mutex> lock(queue_mutex);
+        if (!stop) {
+            for (size_t i = 0; i < helpers; ++i) {
+                // Helpers only touch `body` while chunks remain, and the caller
+                // does not return until every chunk has completed.
+                tasks.emplace(run_chunks);
+            }
+        }
+    }
+    if (helpers > 0) condition.notify_all();
+
+    run_chunks();
+
+    {
+        unique_lock<mutex> lock(state->done_mutex);
+        state->done_cv.wait(lock, [&state] { return state->remaining.load() == 0; });
+    }
+
+    if (state->error) rethrow_exception(state->error);
+}
+
+template<class F>
+void ThreadPool::parallel_for(size_t begin, size_t end, F&& body, size_t min_grain) {
+    parallel_for_range(begin, end, [&body](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            body(i);
+        }
+    }, min_grain);
+}
+
+template<class F>
+void ThreadPool::parallel_for_static(size_t begin, size_t end, F&& body, size_t align) {
+    if (begin >= end) return;
+    const size_t parts = workers.size();
+    if (parts == 0) {
+        body(begin, end);
+        return;
+    }
+
+    struct StaticState {
+        atomic<size_t> remaining;
+        mutex done_mutex;
+        condition_variable done_cv;
+        exception_ptr error;
+        mutex error_mutex;
+        explicit StaticState(size_t n) : remaining(n) {}
+    };
+    auto state = make_shared<StaticState>(parts);
+
+    auto run_part = [state, &body](size_t lo, size_t hi) {
+        if (lo < hi) {
+            try {
+                body(lo, hi);
+            } catch (...) {
+                lock_guard<mutex> lock(state->error_mutex);
+                if (!state->error) state->error = current_exception();
+            }
+        }
+        if (state->remaining.fetch_sub(1) == 1) {
+            lock_guard<mutex> lock(state->done_mutex);
+            state->done_cv.notify_all();
+        }
+    };
+
+    // A waiting worker takes its own queue before the shared one; a busy one
+    // (possibly the caller itself) would hold its range up, so run it here
+    vector<size_t> local;
+    {
+        unique_lock<mutex> lock(queue_mutex);
+        for (size_t w = 0; w < parts; ++w) {
+            if (!stop && worker_waiting[w]) {
+                pair<size_t, size_t> range = static_range(w, begin, end, align);
+                worker_tasks[w].emplace([run_part, range]() { run_part(range.first, range.second); });
+            } else {
+                local.push_back(w);
+            }
+        }
+    }
+    if (local.size() < parts) condition.notify_all();
+
+    for (size_t w : local) {
+        pair<size_t, size_t> range = static_range(w, begin, end, align);
+        run_part(range.first, range.second);
+    }
+
+    {
+        unique_lock<mutex> lock(state->done_mutex);
+        state->done_cv.wait(lock, [&state] { return state->remaining.load() == 0; });
+    }
+
+    if (state->error) rethrow_exception(state->error);
+}
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,88 @@
+#ifndef TRAFFIC_ENV_H
+#define TRAFFIC_ENV_H
+
+#include "fast_forward.h"
+#include "thread_pool.h"
+#include "philox.h"
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// CONTROL ENVIRONMENT
+// ================================
+
+struct EnvStep {
+    float reward;
+    bool done;
+};
+
+// Gym-style environment over the fast-forward engine: actions choose one
+// phase per traffic controller, and one step is one token cycle.
+//
+// Observations are written straight into a caller-owned float buffer of
+// observation_size() values:
+//   [0, n)        queue length per node
+//   [n, 2n)       occupancy / capacity per node
+//   [2n, 2n + C)  active phase index per controller, -1 when all open
+// Action c is a phase index into controller c's approaches (see
+// approach_of); negative or out-of-range leaves every approach open.
+// Reward is minus the vehicles still in the network after the step.
+class TrafficEnv {
+public:
+    // arrival_rate: mean new vehicles per tick, placed at random nodes with
+    // random destinations drawn from the snapshot's routing rows.
+    TrafficEnv(const NetworkSnapshot& network, size_t max_ticks, double arrival_rate);
+
+    size_t observation_size() const { return 2 * net.node_count + controllers; }
+    size_t action_size() const { return controllers; }
+    int phase_count(size_t controller) const;
+    int approach_of(size_t controller, int phase) const;
+
+    void reset(uint64_t seed, float* observation);
+    EnvStep step(const int* actions, float* observation);
+    void observe(float* observation) const;
+
+    const FastForwardSimulator& simulator() const { return sim; }
+
+private:
+    void spawn_arrivals();
+
+    const NetworkSnapshot& net;
+    FastForwardSimulator sim;
+    size_t controllers;
+    size_t max_ticks;
+    double arrival_rate;
+
+    vector<int> active_phase;   // per controller, -1 when open
+    uint64_t episode_seed = 0;      // arrivals are keyed by (episode_seed, tick)
+};
+
+// N independent environments stepped in one call. Buffers are contiguous
+// per environment: observations [N * observation_size()], actions
+// [N * action_size()], rewards and dones [N]. An environment that finishes
+// is reset in place (seed advanced) and its slot holds the new episode's
+// first observation, with dones[i] = 1 marking the boundary.
+class VectorTrafficEnv {
+public:
+    VectorTrafficEnv(const NetworkSnapshot& network, size_t num_envs, ThreadPool& pool,
+                     size_t max_ticks, double arrival_rate);
+
+    size_t size() const { return envs.size(); }
+    size_t observation_size() const { return envs.front().observation_size(); }
+    size_t action_size() const { return envs.front().action_size(); }
+    TrafficEnv& env(size_t i) { return envs[i]; }
+
+    void reset(uint64_t seed, float* observations);
+    void step(const int* actions, float* observations, float* rewards, uint8_t* dones);
+
+private:
+    vector<TrafficEnv> envs;
+    vector<uint64_t> next_seed;
+    ThreadPool& pool;
+};
+
+#endif // TRAFFIC_ENV_H
@@ -4,10 +4,30 @@
 #include "types.h"
 #include "data_structures.h"
 #include "thread_pool.h"
+#include "task_graph.h"
+#include "agent_executor.h"
+#include "stop_token.h"
+#include "node_kernels.h"
+#include "active_set.h"
+#include "flow_model.h"
+#include "signal_control.h"
+#include "fast_forward.h"
+#include "state_export.h"
+#include "spatial_index.h"
+#include "reference_engine.h"
+#include "philox.h"
+#include "delay_model.h"
+#include "admission_control.h"
+#include "vehicle_classes.h"
+#include "steady_state.h"
+#include "congestion_tracker.h"
+#include "fairness_monitor.h"
+#include "vehicle_trace.h"
 #include "traffic_validator.h"
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
+#include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
@@ -39,12 +59,133 @@ private:
     TrafficValidator validator;
 
     atomic<bool> simulation_running{false};
-    atomic<bool> shutdown_requested{false};
     atomic<bool> step_ready{false};
     atomic<bool> waiting_for_step{false};
     atomic<int> next_vehicle_id{1};
     atomic<int> active_threads{0};
 
+    // Cooperative cancellation shared by every simulation loop
+    StopSource stop_source;
+    StopToken stop_token;
+    mutex thread_exit_mutex;
+    condition_variable cv_threads_done;
+
+    // Per-tick routing plan for the head vehicle of each node queue
+    struct RoutePlan {
+        int vehicle_id = -1;
+        int next_hop = -1;
+        float travel_ms = -1.0f;     // batch-sampled when travel is stochastic
+    };
+    vector<RoutePlan> planned_hops;
+
+    // Vehicles travelling to a node join its queue at the start of the tick
+    // their travel ends, in arrival order. offset_ms is how far into that
+    // tick they arrive; a node with service time serves only the rest of it.
+    struct PendingArrival {
+        uint32_t tick;
+        float offset_ms;
+        uint64_t seq;
+        Vehicle vehicle;
+        bool operator>(const PendingArrival& other) const {
+            if (tick != other.tick) return tick > other.tick;
+            if (offset_ms != other.offset_ms) return offset_ms > other.offset_ms;
+            return seq > other.seq;
+        }
+    };
+    priority_queue<PendingArrival, vector<PendingArrival>, greater<PendingArrival>> arrivals;
+    vector<int> in_transit;                // per node, vehicles still travelling in
+    uint64_t arrival_seq = 0;
+
+    // Nodes with queued vehicles; engine loops iterate only these
+    ActiveNodeSet active_nodes;
+
+    // Vectorized per-tick node state (utilization, status, work masks).
+    // Only blocks touched since the last refresh are gathered again; an
+    // empty dirty table forces a full refresh after a (re)load.
+    NodeStateArrays node_state;
+    vector<uint8_t> node_state_dirty;       // per NodeKernels::BLOCK
+    vector<uint32_t> dirty_state_blocks;
+
+    // One lightweight agent per node replaces the old thread-per-node loop.
+    // Nodes whose head was blocked this tick wake on freed downstream
+    // capacity and queue a retry for the token loop (under the coordinator
+    // mutex), which serves them before the next tick.
+    AgentExecutor node_agents;
+    vector<vector<int>> upstream_nodes;
+    vector<uint8_t> head_blocked;
+    vector<uint32_t> blocked_nodes;
+    vector<uint32_t> agent_worklist;
+
+    // Max-pressure phases for TRAFFIC_CONTROLLER nodes, updated every tick
+    SignalController signals;
+    vector<int> head_hops;
+    vector<uint32_t> head_hop_nodes;         // entries of head_hops set last tick
+    vector<uint32_t> head_hop_stamp;
+    uint32_t head_hop_epoch = 0;
+    SignalPlan signal_plan;          // SIGNAL_CONTROL: FIXED_PLAN
+    size_t signal_tick = 0;
+
+    // Live state published to shared memory (STATE_EXPORT)
+    SharedStateExporter state_export;
+    vector<int> edge_offset;               // CSR over nodes[i].adjacent_nodes
+    vector<uint32_t> edge_moves;           // cumulative vehicle moves per edge
+    vector<uint32_t> edge_moves_published;
+    uint64_t export_tick = 0;
+
+    // Nodes simulated as individual vehicles in HYBRID mode
+    vector<bool> focus_region;
+
+    // Optional node positions; when every node has one, routing runs A*
+    // over straight-line edge lengths instead of hop-count BFS
+    vector<GeoPoint> node_positions;
+    SpatialIndex spatial_index;
+
+    // Travel and service time distributions. Model 0 is TRAVEL_TIME, model 1
+    // SERVICE_TIME; # Travel Times and # Service Times entries follow.
+    static constexpr uint16_t NO_DELAY_MODEL = 0xFFFF;
+    vector<DelayModel> delay_models;
+    unordered_map<int, uint16_t> edge_delay_spec;   // from * n + to
+    vector<uint16_t> node_delay_spec;
+    vector<uint16_t> edge_travel_model;             // CSR over edge_offset
+    vector<uint16_t> node_service_model;
+    vector<double> service_credit_ms;
+    vector<float> service_pending_ms;               // 0 when none drawn yet
+    bool stochastic_travel = false;
+    bool delays_configured = false;
+    CounterRng delay_rng;
+    uint32_t token_tick = 0;
+    vector<uint32_t> delay_streams;
+    vector<uint16_t> delay_model_of;
+    vector<uint32_t> delay_nodes;
+    vector<double> delay_uniforms;
+    vector<float> delay_samples;
+
+    // Metered demand at # Entry Points (token loop only)
+    AdmissionController admission;
+
+    // Per-node, per-class occupancy limit: capacity plus the class headroom,
+    // minus slots reserved for other classes under # Reserved Capacity.
+    // Indexed [node * VEHICLE_CLASS_COUNT + class].
+    vector<int32_t> class_reserved;
+    vector<int32_t> class_limit;
+    // Emergency queue rank per [node * VEHICLE_CLASS_COUNT + class]; the
+    // class table's priority unless # Class Priority overrides it
+    vector<uint8_t> class_priority;
+
+    // Hottest nodes, kept current on every queue or occupancy change
+    CongestionTracker congestion;
+    vector<int32_t> node_blocked;           // blocks since the last departure
+    vector<uint32_t> hottest_nodes;
+
+    // Queue ages, service ratios and starvation alarms per (node, class)
+    FairnessMonitor fairness;
+
+    // Hops, waits and blocks of a deterministic sample of vehicles
+    VehicleTracer tracer;
+
+    // Why an automatic run ended before SIMULATION_TIME; empty if it did not
+    string early_stop_reason;
+
 public:
     TrafficNetwork();
     ~TrafficNetwork();
@@ -52,6 +193,20 @@ public:
     bool initialize(const string& input_file);
     void run_simulation();
 
+    // Read-only copy of the loaded network for headless engines (optimizer,
+    // control environments). Valid while this network is alive.
+    void export_snapshot(NetworkSnapshot& snapshot) const {
+        snapshot.build(nodes, signals, class_limit, class_priority);
+    }
+
+    // Empty unless the input gave coordinates for every node
+    const SpatialIndex& get_spatial_index() const { return spatial_index; }
+
+    // Random scenarios through the token tick and ReferenceEngine, comparing
+    // event traces and checking invariants every tick. Menu option 8 and
+    // --check; true when every scenario matched.
+    bool run_differential_check();
+
 private:
     // Simulation mode selection
     void select_simulation_mode();
@@ -60,16 +215,37 @@ private:
     void run_step_by_step_simulation();
     bool execute_single_step();
     bool process_single_vehicle_movement(size_t node_idx);
-    bool process_vehicle_step_by_step(Vehicle& vehicle, size_t from_node, bool is_emergency);
-    void perform_vehicle_move_with_display(Vehicle& vehicle, size_t from_node, int to_node);
 
     // Automatic simulation methods
     void run_automatic_simulation();
+    void wait_for_run_end();
+    bool network_drained();
+
+    // Mesoscopic flow simulation
+    void run_flow_simulation();
+
+    // Hybrid simulation: vehicle engine in the focus region, flows elsewhere
+    void run_hybrid_simulation();
+    int absorb_into_flow(FlowModel& model, size_t node_idx);
+    void record_flow_moves(const FlowModel& model, double t, uint64_t& recorded);
+    void sync_flow_occupancy(const FlowModel& model, const vector<bool>& micro);
+
+    // Offline fixed-time plan search; writes config.signal_plan_file
+    void run_signal_optimizer();
+
+    // Random-action rollouts through VectorTrafficEnv, reporting step cost
+    void run_env_benchmark();
+
+    void load_scenario(const DifferentialScenario& scenario);
+    void run_recorded_tick(vector<MovementEvent>& events);
+    string check_engine_invariants(size_t total_vehicles) const;
 
     // Display methods
     void display_initial_state();
     void display_current_state();
     void display_node_status_table();
+    void display_congested_nodes(size_t k);
+    void display_fairness_report();
     void display_quick_stats();
     void display_network_summary();
     void display_simulation_start();
@@ -88,33 +264,100 @@ private:
                           unordered_set<char>& controllers,
                           unordered_map<char, int>& traffic,
                           unordered_map<char, int>& ambulances,
-                          unordered_map<char, int>& fire_trucks, int n);
+                          unordered_map<char, int>& fire_trucks,
+                          unordered_map<char, int>& buses,
+                          unordered_map<char, int>& freight, int n);
     void apply_configuration(const unordered_map<char, int>& capacities,
                            const unordered_set<char>& controllers,
                            const unordered_map<char, int>& traffic,
                            const unordered_map<char, int>& ambulances,
-                           const unordered_map<char, int>& fire_trucks, int n);
+                           const unordered_map<char, int>& fire_trucks,
+                           const unordered_map<char, int>& buses,
+                           const unordered_map<char, int>& freight, int n);
     void add_vehicles_to_nodes(const unordered_map<char, int>& traffic,
                              const unordered_map<char, int>& ambulances,
-                             const unordered_map<char, int>& fire_trucks, int n);
+                             const unordered_map<char, int>& fire_trucks,
+                             const unordered_map<char, int>& buses,
+                             const unordered_map<char, int>& freight, int n);
     bool create_sample_input();
     void add_sample_vehicles();
 
     // Threading methods
+    void configure_workers();
     void token_allocation_loop();
-    void process_node_vehicles(size_t node_idx);
-    void process_vehicle(Vehicle& vehicle, size_t from_node, bool is_emergency);
-    void traffic_processing_loop(size_t node_idx);
+    void refresh_node_state();
+    void plan_next_hops(const vector<uint32_t>& active);
+    void update_signals(const vector<uint32_t>& active);
+    int next_hop_for(const Vehicle& vehicle, size_t from_node);
+    // One token tick: metering, route and delay planning, signals, then
+    // service at each active node (only nodes marked in served, if given).
+    // The token loop, the hybrid loop and the differential check share it.
+    template<class Observer>
+    void run_tick(Observer& observer, const vector<bool>* served = nullptr);
+    template<class Observer>
+    void process_node_vehicles(size_t node_idx, Observer& observer);
+    template<class Observer>
+    bool serve_node_vehicle(size_t node_idx, Observer& observer);
+    void build_delay_models();
+    uint16_t add_delay_model(const string& spec, const string& where);
+    void build_edge_offsets();
+    uint16_t travel_model_at(size_t from_node, int to_node) const;
+    void sample_tick_delays(const vector<uint32_t>& active);
+    double travel_delay_ms(const Vehicle& vehicle, size_t from_node);
+    void begin_travel(Vehicle& vehicle, size_t from_node, size_t to_node);
+    void release_arrivals();
+    void reset_arrivals();
+    void meter_entry_traffic();
+    void start_node_agents();
+    AgentAwait resume_node_agent(AgentExecutor::AgentId agent, uint8_t fired);
+    void notify_capacity_freed(size_t node_idx);
+    void mark_head_blocked(size_t node_idx);
+    void clear_blocked_heads();
+    template<class Observer>
+    void retry_woken_nodes(Observer& observer);
     void ui_update_loop();
 
     // Vehicle movement methods
+    void enqueue_vehicle(size_t node_idx, Vehicle vehicle, bool is_emergency);
+    void queue_vehicle(size_t node_idx, Vehicle vehicle, bool is_emergency);
+    bool dequeue_vehicle(size_t node_idx, Vehicle& vehicle, bool& is_emergency);
+    const Vehicle* queue_head(size_t node_idx) const;
     void return_vehicle_to_queue(Vehicle& vehicle, size_t node_idx, bool is_emergency);
     int find_best_next_hop(size_t from_node, int destination);
-    bool can_move_to_node_safe(int node_idx, VehicleType vehicle_type);
-    void perform_vehicle_move(Vehicle& vehicle, size_t from_node, int to_node);
+    int find_geometric_next_hop(size_t from_node, int destination) const;
+    int route_next_hop(const Vehicle& vehicle, size_t from_node);
+    void build_spatial_index();
+    void load_gps_trips();
+    bool can_move_to_node_safe(int node_idx, VehicleType vehicle_type) const;
+    void build_class_limits();
     void attempt_rerouting(Vehicle& vehicle, size_t current_node);
+    void record_block(size_t from_node, const Vehicle& vehicle);
+    void build_congestion_tracker();
+    CongestionKey congestion_key(size_t node_idx) const;
+    void touch_node(size_t node_idx);
+    void configure_tracer();
+    void write_vehicle_trace();
+    Vehicle make_vehicle(int id, VehicleType type, int source, int destination) const;
+    void trace(TraceKind kind, const Vehicle& vehicle, size_t node, int detail = -1) {
+        if (vehicle.traced) tracer.record(kind, vehicle.vehicle_id, static_cast<int>(node), detail);
+    }
+
+    // Movement engine shared by every mode. Observer is a policy from
+    // movement_observers.h; the silent policy compiles to no display work.
+    // Both return true when the vehicle left from_node.
+    template<class Observer>
+    bool process_vehicle(Vehicle& vehicle, size_t from_node, bool is_emergency, Observer& observer);
+    template<class Observer>
+    bool perform_vehicle_move(Vehicle& vehicle, size_t from_node, int to_node, Observer& observer);
+
+    // Shared-memory state export
+    void open_state_export();
+    void record_edge_move(size_t from_node, int to_node);
+    void publish_state(double simulated_seconds, const FlowModel* flow = nullptr);
 
     // Utility methods
+    void enter_loop();
+    void exit_loop();
     void shutdown();
 };
 
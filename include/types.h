@@ -1,6 +1,8 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <cstdint>
+
 // ================================
 // SIMULATION MODE ENUMS
 // ================================
@@ -8,17 +10,32 @@
 enum class SimulationMode {
     AUTOMATIC,        // Runs automatically with real-time dashboard
     STEP_BY_STEP,    // Step-by-step with manual advancement
-    FAST_RUN         // Fast execution with final results only
+    FAST_RUN,        // Fast execution with final results only
+    MESOSCOPIC,      // Cell-transmission flow model, no per-vehicle objects
+    HYBRID,          // Vehicles inside the focus region, flows elsewhere
+    SIGNAL_OPTIMIZER,// Offline search for fixed-time signal plans
+    ENV_BENCHMARK,   // Random-action rollouts through the control environment
+    DIFFERENTIAL_CHECK // Random scenarios vs the sequential reference engine
+};
+
+// How TRAFFIC_CONTROLLER nodes pick which approach gets green
+enum class SignalPolicy {
+    NONE,            // Controllers admit every approach
+    MAX_PRESSURE,    // Green for the approach with the highest queue pressure
+    FIXED_PLAN       // Cycle through a plan file written by the optimizer
 };
 
 // ================================
 // CORE ENUMS
 // ================================
 
+// Traits for each type live in vehicle_classes.h
 enum class VehicleType {
     REGULAR = 0,
     FIRE_TRUCK = 1,
-    AMBULANCE = 2
+    AMBULANCE = 2,
+    BUS = 3,
+    FREIGHT = 4
 };
 
 enum class NodeType {
@@ -26,6 +43,39 @@ enum class NodeType {
     TRAFFIC_CONTROLLER
 };
 
+// Ordered by severity so kernels can compute it as a threshold count
+enum class NodeStatus : uint8_t {
+    LOW = 0,
+    NORMAL = 1,
+    HIGH = 2,
+    CRITICAL = 3
+};
+
+// Movement outcomes recorded for engine comparison
+enum class MovementEventKind : uint8_t {
+    MOVE,
+    ARRIVE,
+    BLOCKED,
+    BOUNCED,
+    RED_SIGNAL,
+    NO_PATH
+};
+
+// When automatic and fast runs may end before SIMULATION_TIME
+enum class EarlyStop {
+    NONE,            // Always run the full time
+    DRAIN,           // Stop once no vehicle is left or waiting to enter
+    STEADY_STATE     // Also stop once throughput has converged
+};
+
+// Travel and service time distributions (delay_model.h)
+enum class DelayDistribution {
+    FIXED,
+    LOGNORMAL,
+    GAMMA,
+    EMPIRICAL
+};
+
 enum class InputValidationResult {
     INPUT_VALID = 0,
     INVALID_ADJACENCY_MATRIX,
@@ -0,0 +1,73 @@
+#ifndef VEHICLE_CLASSES_H
+#define VEHICLE_CLASSES_H
+
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+// ================================
+// VEHICLE CLASS TABLE
+// ================================
+
+// Everything the engine needs to know about a vehicle type, indexed by
+// VehicleType so each question is one constexpr load instead of a switch.
+//   emergency: served from the emergency queue and may run red signals
+//   priority:  emergency queue order, higher first; other classes queue
+//              FIFO, so theirs is 0
+//   headroom:  slots allowed above a node's capacity (the emergency +1)
+struct VehicleClassTraits {
+    const char* key;        // name in input files
+    const char* tag;        // short form in vehicle labels
+    const char* display;
+    bool emergency;
+    uint8_t priority;
+    int8_t headroom;
+};
+
+constexpr size_t VEHICLE_CLASS_COUNT = 5;
+
+constexpr VehicleClassTraits VEHICLE_CLASSES[VEHICLE_CLASS_COUNT] = {
+    // key          tag     display       emerg  prio  room
+    {"REGULAR",    "REG",  "Regular",    false, 0,    0},
+    {"FIRE_TRUCK", "FIRE", "Fire Truck", true,  2,    1},
+    {"AMBULANCE",  "AMB",  "Ambulance",  true,  3,    1},
+    {"BUS",        "BUS",  "Bus",        false, 0,    0},
+    {"FREIGHT",    "FRT",  "Freight",    false, 0,    0},
+};
+
+constexpr const VehicleClassTraits& vehicle_class(VehicleType type) {
+    return VEHICLE_CLASSES[static_cast<size_t>(type)];
+}
+
+constexpr size_t vehicle_class_index(VehicleType type) {
+    return static_cast<size_t>(type);
+}
+
+// Input-file name to type; false for unknown names
+inline bool parse_vehicle_class(const char* key, VehicleType& type) {
+    for (size_t c = 0; c < VEHICLE_CLASS_COUNT; ++c) {
+        if (strcmp(VEHICLE_CLASSES[c].key, key) == 0) {
+            type = static_cast<VehicleType>(c);
+            return true;
+        }
+    }
+    return false;
+}
+
+static_assert(vehicle_class(VehicleType::AMBULANCE).priority > vehicle_class(VehicleType::FIRE_TRUCK).priority,
+              "ambulances are served before fire trucks");
+constexpr bool only_emergency_ranked() {
+    for (size_t c = 0; c < VEHICLE_CLASS_COUNT; ++c) {
+        if (!VEHICLE_CLASSES[c].emergency && VEHICLE_CLASSES[c].priority != 0) return false;
+    }
+    return true;
+}
+
+static_assert(only_emergency_ranked(), "only the emergency queue is ordered by priority");
+static_assert(!vehicle_class(VehicleType::REGULAR).emergency && vehicle_class(VehicleType::REGULAR).headroom == 0,
+              "regular vehicles use the plain capacity");
+
+#endif // VEHICLE_CLASSES_H
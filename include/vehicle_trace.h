@@ -0,0 +1,84 @@
+#ifndef VEHICLE_TRACE_H
+#define VEHICLE_TRACE_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// SAMPLED VEHICLE TRACING
+// ================================
+
+enum class TraceKind : uint8_t {
+    WAIT,       // picked for service; detail = ms queued at the node
+    HOP,        // moved; detail = node moved to
+    BLOCK,      // next node full; detail = that node
+    RED,        // held by a signal; detail = next node
+    BOUNCE,     // next node filled before the move committed; detail = that node
+    NO_PATH,    // no route from the node
+    REROUTE,    // gave up on the current hop after repeated blocks
+    ARRIVE      // reached the destination; detail = journey ms
+};
+
+struct TraceEvent {
+    uint32_t time_us;       // since the trace started; wraps after ~71 minutes
+    int32_t vehicle_id;
+    int32_t node;
+    int32_t detail;
+    TraceKind kind;
+};
+
+static_assert(sizeof(TraceEvent) <= 20, "trace events stay compact");
+
+// Deterministic per-vehicle sampling: a vehicle is traced when a keyed
+// 64-bit hash of its id falls below rate * 2^64, so the same vehicles are
+// traced on every run with the same seed. The network hashes each vehicle
+// once when it is created and keeps the answer in Vehicle::traced, so an
+// unsampled vehicle pays one well-predicted branch per event; with tracing
+// off the threshold is 0 and nothing is ever sampled. Sampled events go into a buffer
+// reserved up front and are dropped, not reallocated, once it is full.
+class VehicleTracer {
+public:
+    void configure(double rate, uint64_t seed_key, size_t capacity);
+
+    bool enabled() const { return threshold != 0; }
+
+    bool sampled(int vehicle_id) const {
+        return mix(static_cast<uint64_t>(static_cast<uint32_t>(vehicle_id)) ^ key) < threshold;
+    }
+
+    void record(TraceKind kind, int vehicle_id, int node, int detail);
+
+    size_t size() const { return events.size(); }
+    uint64_t dropped() const { return overflow; }
+    size_t vehicle_count() const;
+
+    // CSV, one event per line in recording order; node names come from
+    // `names`. Returns false if the file cannot be written.
+    bool write(const string& path, const vector<char>& names) const;
+
+    static const char* kind_name(TraceKind kind);
+
+private:
+    // splitmix64 finalizer
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    uint64_t threshold = 0;
+    uint64_t key = 0;
+    size_t limit = 0;
+    uint64_t overflow = 0;
+    vector<TraceEvent> events;
+    chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+};
+
+#endif // VEHICLE_TRACE_H
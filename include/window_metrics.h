@@ -0,0 +1,72 @@
+#ifndef WINDOW_METRICS_H
+#define WINDOW_METRICS_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ================================
+// SLIDING-WINDOW METRICS
+// ================================
+
+// Counters over the most recent stretch of a run
+struct WindowSummary {
+    double seconds = 0.0;           // span actually covered
+    uint64_t moves = 0;
+    uint64_t arrivals = 0;
+    uint64_t blocks = 0;
+    double throughput = 0.0;        // moves per second
+    double arrival_rate = 0.0;      // completed journeys per second
+    double latency_mean_ms = 0.0;   // journey time of the window's arrivals
+    double latency_p50_ms = 0.0;
+    double latency_p95_ms = 0.0;
+};
+
+// Ring of fixed-width time buckets. Each slot stores the cumulative totals
+// at the start of its bucket, so any window ending now is the difference
+// between the running totals and one slot: O(1) in the window length.
+// Journey latencies go into a log-scaled histogram with quarter-octave
+// bins (about 19% relative resolution); percentiles read the differenced
+// histogram. Advancing across idle buckets is amortized O(1) per bucket
+// and never more than one full ring per call.
+class WindowMetrics {
+public:
+    static constexpr size_t LATENCY_BINS = 80;    // 1 ms to ~14 min
+
+    WindowMetrics(double bucket_seconds = 0.25, size_t history = 240);
+    void configure(double bucket_seconds, size_t history);
+
+    // t is seconds since the run started and must not go backwards
+    void record_move(double t);
+    void record_moves(double t, uint64_t count);    // aggregate flow sweeps
+    void record_arrival(double t, double latency_ms);
+    void record_block(double t);
+
+    // The last `seconds` up to t, clipped to the ring and the run so far
+    WindowSummary window(double t, double seconds);
+
+    double bucket_seconds() const { return bucket_width; }
+    double history_seconds() const { return bucket_width * ring.size(); }
+
+private:
+    struct Totals {
+        uint64_t moves = 0;
+        uint64_t arrivals = 0;
+        uint64_t blocks = 0;
+        double latency_sum_ms = 0.0;
+        uint32_t latency_bins[LATENCY_BINS] = {};
+    };
+
+    void advance(double t);
+    static size_t latency_bin(double latency_ms);
+    static double bin_upper_ms(size_t bin);
+
+    double bucket_width;
+    vector<Totals> ring;        // totals at the start of bucket b, slot b % size
+    Totals running;
+    int64_t head = 0;           // bucket that running is accumulating into
+};
+
+#endif // WINDOW_METRICS_H
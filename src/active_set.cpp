@@ -0,0 +1,50 @@
+#include "active_set.h"
+#include <algorithm>
+
+using namespace std;
+
+void ActiveNodeSet::reset(size_t node_count) {
+    size_t words = (node_count + 63) / 64;
+    bits.reset(new atomic<uint64_t>[words]);
+    for (size_t w = 0; w < words; ++w) {
+        bits[w].store(0, memory_order_relaxed);
+    }
+    capacity = node_count;
+    worklist.clear();
+    worklist.reserve(node_count);
+    position.assign(node_count, NOT_ACTIVE);
+}
+
+bool ActiveNodeSet::insert(size_t node) {
+    if (node >= capacity || position[node] != NOT_ACTIVE) return false;
+    position[node] = static_cast<uint32_t>(worklist.size());
+    worklist.push_back(static_cast<uint32_t>(node));
+    bits[node >> 6].fetch_or(1ULL << (node & 63), memory_order_relaxed);
+    return true;
+}
+
+bool ActiveNodeSet::erase(size_t node) {
+    if (node >= capacity || position[node] == NOT_ACTIVE) return false;
+
+    // Swap-remove: move the last entry into the vacated slot
+    uint32_t slot = position[node];
+    uint32_t last = worklist.back();
+    worklist[slot] = last;
+    position[last] = slot;
+    worklist.pop_back();
+    position[node] = NOT_ACTIVE;
+
+    bits[node >> 6].fetch_and(~(1ULL << (node & 63)), memory_order_relaxed);
+    return true;
+}
+
+bool ActiveNodeSet::contains(size_t node) const {
+    if (node >= capacity) return false;
+    return (bits[node >> 6].load(memory_order_relaxed) >> (node & 63)) & 1;
+}
+
+vector<uint32_t> ActiveNodeSet::snapshot() const {
+    vector<uint32_t> active(worklist);
+    sort(active.begin(), active.end());
+    return active;
+}
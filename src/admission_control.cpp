@@ -0,0 +1,49 @@
+#include "admission_control.h"
+
+using namespace std;
+
+// ================================
+// ENTRY ADMISSION CONTROL
+// ================================
+
+void AdmissionController::add_entry(int node, double meter_rate) {
+    for (EntryPoint& entry : entries) {
+        if (entry.node == node) {
+            entry.meter_rate = meter_rate;
+            return;
+        }
+    }
+    EntryPoint entry;
+    entry.node = node;
+    entry.meter_rate = meter_rate;
+    entries.push_back(entry);
+}
+
+size_t AdmissionController::room(size_t k) const {
+    size_t held = entries[k].buffer.size();
+    return held < capacity ? capacity - held : 0;
+}
+
+size_t AdmissionController::buffered() const {
+    size_t total = 0;
+    for (const EntryPoint& entry : entries) total += entry.buffer.size();
+    return total;
+}
+
+uint64_t AdmissionController::generated() const {
+    uint64_t total = 0;
+    for (const EntryPoint& entry : entries) total += entry.generated;
+    return total;
+}
+
+uint64_t AdmissionController::admitted() const {
+    uint64_t total = 0;
+    for (const EntryPoint& entry : entries) total += entry.admitted;
+    return total;
+}
+
+uint64_t AdmissionController::deferred() const {
+    uint64_t total = 0;
+    for (const EntryPoint& entry : entries) total += entry.deferred;
+    return total;
+}
@@ -0,0 +1,111 @@
+#include "agent_executor.h"
+
+using namespace std;
+using namespace chrono;
+
+void AgentExecutor::reset(size_t agent_count, StepFunction step) {
+    lock_guard<mutex> lock(executor_mutex);
+    agents.assign(agent_count, AgentSlot{});
+    ready.clear();
+    timers = decltype(timers)();
+    step_function = move(step);
+    stopping = false;
+}
+
+void AgentExecutor::make_ready(AgentId agent) {
+    AgentSlot& slot = agents[agent];
+    if (slot.queued || slot.running) return;
+    slot.queued = true;
+    ready.push_back(agent);
+}
+
+void AgentExecutor::signal(AgentId agent, uint8_t events) {
+    {
+        lock_guard<mutex> lock(executor_mutex);
+        if (agent >= agents.size()) return;
+        AgentSlot& slot = agents[agent];
+        slot.pending |= events;
+        if (!(slot.awaiting & events)) return;
+        make_ready(agent);
+    }
+    executor_cv.notify_one();
+}
+
+void AgentExecutor::start() {
+    {
+        lock_guard<mutex> lock(executor_mutex);
+        for (AgentId id = 0; id < agents.size(); ++id) {
+            make_ready(id);
+        }
+    }
+    executor_cv.notify_all();
+}
+
+void AgentExecutor::stop() {
+    {
+        lock_guard<mutex> lock(executor_mutex);
+        stopping = true;
+    }
+    executor_cv.notify_all();
+}
+
+void AgentExecutor::suspend(AgentId agent, const AgentAwait& await) {
+    AgentSlot& slot = agents[agent];
+    slot.running = false;
+    slot.awaiting = await.events;
+    slot.timer_generation++;
+
+    if (await.timeout.count() > 0) {
+        slot.awaiting |= AgentEvent::TIMER;
+        slot.deadline = steady_clock::now() + await.timeout;
+        timers.push(TimerEntry{slot.deadline, agent, slot.timer_generation});
+    }
+
+    // An event that fired while the agent was running resumes it immediately
+    if (slot.pending & slot.awaiting) {
+        make_ready(agent);
+    }
+}
+
+void AgentExecutor::run() {
+    unique_lock<mutex> lock(executor_mutex);
+    while (!stopping) {
+        // Fire expired timers; stale entries belong to an earlier await
+        auto now = steady_clock::now();
+        while (!timers.empty() && timers.top().deadline <= now) {
+            TimerEntry entry = timers.top();
+            timers.pop();
+            AgentSlot& slot = agents[entry.agent];
+            if (entry.generation == slot.timer_generation && (slot.awaiting & AgentEvent::TIMER)) {
+                slot.pending |= AgentEvent::TIMER;
+                make_ready(entry.agent);
+            }
+        }
+
+        if (ready.empty()) {
+            if (timers.empty()) {
+                executor_cv.wait(lock, [this]() { return stopping || !ready.empty(); });
+            } else {
+                executor_cv.wait_until(lock, timers.top().deadline,
+                                       [this]() { return stopping || !ready.empty(); });
+            }
+            continue;
+        }
+
+        AgentId agent = ready.front();
+        ready.pop_front();
+        AgentSlot& slot = agents[agent];
+        slot.queued = false;
+        slot.running = true;
+        uint8_t fired = slot.pending & (slot.awaiting | AgentEvent::TIMER);
+        slot.pending = AgentEvent::NONE;
+        slot.awaiting = AgentEvent::NONE;
+
+        lock.unlock();
+        AgentAwait next = step_function(agent, fired);
+        resume_count++;
+        lock.lock();
+
+        suspend(agent, next);
+    }
+}
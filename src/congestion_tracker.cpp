@@ -0,0 +1,89 @@
+#include "congestion_tracker.h"
+#include <algorithm>
+
+using namespace std;
+
+// ================================
+// CONGESTION RANKING
+// ================================
+
+void CongestionTracker::build(const vector<CongestionKey>& initial) {
+    keys = initial;
+    heap.resize(keys.size());
+    slot_of.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        heap[i] = static_cast<uint32_t>(i);
+        slot_of[i] = static_cast<uint32_t>(i);
+    }
+    for (size_t slot = heap.size() / 2; slot-- > 0;) sift_down(slot);
+}
+
+void CongestionTracker::clear() {
+    keys.clear();
+    heap.clear();
+    slot_of.clear();
+}
+
+bool CongestionTracker::hotter(uint32_t a, uint32_t b) const {
+    if (keys[b] < keys[a]) return true;
+    if (keys[a] < keys[b]) return false;
+    return a < b;
+}
+
+void CongestionTracker::place(size_t slot, uint32_t node) {
+    heap[slot] = node;
+    slot_of[node] = static_cast<uint32_t>(slot);
+}
+
+void CongestionTracker::sift_up(size_t slot) {
+    uint32_t node = heap[slot];
+    while (slot > 0) {
+        size_t parent = (slot - 1) / 2;
+        if (!hotter(node, heap[parent])) break;
+        place(slot, heap[parent]);
+        slot = parent;
+    }
+    place(slot, node);
+}
+
+void CongestionTracker::sift_down(size_t slot) {
+    uint32_t node = heap[slot];
+    size_t n = heap.size();
+    while (true) {
+        size_t child = 2 * slot + 1;
+        if (child >= n) break;
+        if (child + 1 < n && hotter(heap[child + 1], heap[child])) child++;
+        if (!hotter(heap[child], node)) break;
+        place(slot, heap[child]);
+        slot = child;
+    }
+    place(slot, node);
+}
+
+void CongestionTracker::update(size_t node, const CongestionKey& key) {
+    if (node >= keys.size() || keys[node] == key) return;
+    bool rose = keys[node] < key;
+    keys[node] = key;
+    if (rose) sift_up(slot_of[node]);
+    else sift_down(slot_of[node]);
+}
+
+void CongestionTracker::top(size_t k, vector<uint32_t>& out) const {
+    out.clear();
+    if (heap.empty() || k == 0) return;
+
+    // Frontier of heap slots; a slot's children can only be next once it
+    // has been taken, so the frontier never exceeds k + 1 entries
+    auto cooler = [this](uint32_t a, uint32_t b) { return hotter(heap[b], heap[a]); };
+    vector<uint32_t> frontier{0};
+    while (!frontier.empty() && out.size() < k) {
+        pop_heap(frontier.begin(), frontier.end(), cooler);
+        uint32_t slot = frontier.back();
+        frontier.pop_back();
+        out.push_back(heap[slot]);
+        for (uint32_t child = 2 * slot + 1; child <= 2 * slot + 2 && child < heap.size(); ++child) {
+            frontier.push_back(child);
+            push_heap(frontier.begin(), frontier.end(), cooler);
+        }
+    }
+}
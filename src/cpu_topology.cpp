@@ -0,0 +1,64 @@
+#include "cpu_topology.h"
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#endif
+
+using namespace std;
+
+namespace CpuTopology {
+
+vector<int> allowed_cpus() {
+    vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+#endif
+    if (cpus.empty()) cpus.push_back(0);
+    return cpus;
+}
+
+int numa_node_of_cpu(int cpu) {
+#ifdef __linux__
+    // /sys/devices/system/cpu/cpuN contains a "nodeX" link to its NUMA node
+    string path = "/sys/devices/system/cpu/cpu" + to_string(cpu);
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return 0;
+    int node = 0;
+    while (dirent* entry = readdir(dir)) {
+        string name = entry->d_name;
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+            name.find_first_not_of("0123456789", 4) == string::npos) {
+            node = stoi(name.substr(4));
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+#else
+    (void)cpu;
+    return 0;
+#endif
+}
+
+bool pin_current_thread(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+} // namespace CpuTopology
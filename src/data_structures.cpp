@@ -1,5 +1,8 @@
 #include "data_structures.h"
+#include "node_kernels.h"
+#include "vehicle_classes.h"
 #include <string>
+#include <algorithm>
 
 using namespace std;
 using namespace chrono;
@@ -11,35 +14,21 @@ using namespace chrono;
 Vehicle::Vehicle(int id, VehicleType t, int src, int dest)
     : vehicle_id(id), type(t), source_node(src), destination_node(dest),
       current_node(src), arrival_time(steady_clock::now()),
-      start_time(steady_clock::now()) {}
+      start_time(steady_clock::now()), priority(vehicle_class(t).priority) {}
 
 bool Vehicle::operator<(const Vehicle& other) const {
-    if (type != other.type) {
-        return static_cast<int>(type) < static_cast<int>(other.type);
+    if (priority != other.priority) {
+        return priority < other.priority;
     }
     return arrival_time > other.arrival_time;
 }
 
-double Vehicle::get_priority_weight() const {
-    switch(type) {
-        case VehicleType::AMBULANCE: return 10.0;
-        case VehicleType::FIRE_TRUCK: return 8.0;
-        default: return 1.0;
-    }
-}
-
 string Vehicle::to_string() const {
-    string type_str = (type == VehicleType::AMBULANCE) ? "AMB" :
-                     (type == VehicleType::FIRE_TRUCK) ? "FIRE" : "REG";
-    return "[" + type_str + "-" + std::to_string(vehicle_id) + "]";
+    return "[" + string(vehicle_class(type).tag) + "-" + std::to_string(vehicle_id) + "]";
 }
 
 string Vehicle::get_type_display() const {
-    switch(type) {
-        case VehicleType::AMBULANCE: return "Ambulance";
-        case VehicleType::FIRE_TRUCK: return "Fire Truck";
-        default: return "Regular";
-    }
+    return vehicle_class(type).display;
 }
 
 // ================================
@@ -67,11 +56,7 @@ double NodeData::get_utilization() const {
 }
 
 string NodeData::get_status() const {
-    double util = get_utilization();
-    if (util >= 90.0) return "CRITICAL";
-    if (util >= 75.0) return "HIGH";
-    if (util >= 50.0) return "NORMAL";
-    return "LOW";
+    return NodeKernels::status_name(NodeKernels::classify(current_vehicles, capacity));
 }
 
 string NodeData::get_type_display() const {
@@ -86,6 +71,67 @@ void SystemConfig::load_defaults() {
     // Default values are already set in the header
 }
 
+static bool parse_bool_option(const string& value) {
+    return value == "true" || value == "TRUE" || value == "1" || value == "yes";
+}
+
+bool SystemConfig::apply_option(const string& key, const string& value) {
+    if (key == "TOKEN_CYCLE_DURATION") token_cycle_duration = stod(value);
+    else if (key == "MAX_EMERGENCY_WAIT") max_emergency_wait = stod(value);
+    else if (key == "RETRY_DELAY") retry_delay_ms = stoi(value);
+    else if (key == "SIMULATION_TIME") simulation_time = stod(value);
+    else if (key == "MAX_BLOCK_TIME") max_block_time = stod(value);
+    else if (key == "SHUTDOWN_TIMEOUT") shutdown_timeout = stod(value);
+    else if (key == "FLOW_TIME_STEP") flow_time_step = stod(value);
+    else if (key == "CONSOLE_REFRESH_RATE") console_refresh_rate = stoi(value);
+    else if (key == "ENABLE_COLORS") enable_colors = parse_bool_option(value);
+    else if (key == "WORKER_THREADS") worker_threads = max(1, stoi(value));
+    else if (key == "PIN_WORKER_THREADS") pin_worker_threads = parse_bool_option(value);
+    else if (key == "SIGNAL_CONTROL") {
+        if (value == "MAX_PRESSURE") signal_policy = SignalPolicy::MAX_PRESSURE;
+        else if (value == "FIXED_PLAN") signal_policy = SignalPolicy::FIXED_PLAN;
+        else signal_policy = SignalPolicy::NONE;
+    }
+    else if (key == "SIGNAL_PLAN_FILE") signal_plan_file = value;
+    else if (key == "OPTIMIZER_HORIZON") optimizer_horizon = max(1, stoi(value));
+    else if (key == "OPTIMIZER_ROUNDS") optimizer_rounds = max(0, stoi(value));
+    else if (key == "MAX_GREEN_TICKS") max_green_ticks = max(1, stoi(value));
+    else if (key == "STATE_EXPORT") state_export_name = value;
+    else if (key == "ENV_COUNT") env_count = max(1, stoi(value));
+    else if (key == "ENV_STEPS") env_steps = max(1, stoi(value));
+    else if (key == "ENV_EPISODE_TICKS") env_episode_ticks = max(1, stoi(value));
+    else if (key == "ENV_ARRIVAL_RATE") env_arrival_rate = max(0.0, stod(value));
+    else if (key == "COORDINATE_SYSTEM") geographic_coordinates = value == "GEOGRAPHIC";
+    else if (key == "GPS_TRACE_FILE") gps_trace_file = value;
+    else if (key == "MATCHED_TRIPS_FILE") matched_trips_file = value;
+    else if (key == "GPS_SIGMA") gps_sigma = max(0.0, stod(value));
+    else if (key == "GPS_SEARCH_RADIUS") gps_search_radius = max(0.0, stod(value));
+    else if (key == "DIFF_SCENARIOS") diff_scenarios = max(1, stoi(value));
+    else if (key == "DIFF_MAX_TICKS") diff_max_ticks = max(1, stoi(value));
+    else if (key == "DIFF_SEED") diff_seed = stoull(value);
+    else if (key == "RANDOM_SEED") random_seed = stoull(value);
+    else if (key == "TRAVEL_TIME") travel_time = value;
+    else if (key == "SERVICE_TIME") service_time = value;
+    else if (key == "DEMAND_RATE") demand_rate = max(0.0, stod(value));
+    else if (key == "ENTRY_BUFFER") entry_buffer = max(0, stoi(value));
+    else if (key == "METRICS_BUCKET") metrics_bucket = max(0.001, stod(value));
+    else if (key == "METRICS_HISTORY") metrics_history = max(2, stoi(value));
+    else if (key == "METRICS_WINDOW") metrics_window = max(0.0, stod(value));
+    else if (key == "EARLY_STOP") {
+        if (value == "NONE") early_stop = EarlyStop::NONE;
+        else if (value == "STEADY_STATE") early_stop = EarlyStop::STEADY_STATE;
+        else early_stop = EarlyStop::DRAIN;
+    }
+    else if (key == "STEADY_PRECISION") steady_precision = max(0.0, stod(value));
+    else if (key == "STEADY_BATCHES") steady_batches = max(2, stoi(value));
+    else if (key == "TOP_K_NODES") top_k_nodes = max(1, stoi(value));
+    else if (key == "TRACE_SAMPLE_RATE") trace_sample_rate = min(1.0, max(0.0, stod(value)));
+    else if (key == "TRACE_FILE") trace_file = value;
+    else if (key == "TRACE_BUFFER") trace_buffer = max(0, stoi(value));
+    else return false;
+    return true;
+}
+
 // ================================
 // SYSTEM STATS IMPLEMENTATION
 // ================================
@@ -98,6 +144,11 @@ double SystemStats::get_success_rate() const {
 }
 
 double SystemStats::get_throughput() const {
-    auto elapsed = duration_cast<seconds>(steady_clock::now() - start_time).count();
-    return elapsed > 0 ? (double)total_moves / elapsed : 0.0;
+    double elapsed = elapsed_seconds();
+    return elapsed > 0.0 ? total_moves / elapsed : 0.0;
+}
+
+double SystemStats::elapsed_seconds() const {
+    if (simulated_seconds >= 0.0) return simulated_seconds;
+    return duration<double>(steady_clock::now() - start_time).count();
 }
\ No newline at end of file
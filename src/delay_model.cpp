@@ -0,0 +1,127 @@
+#include "delay_model.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using namespace std;
+
+// ================================
+// DELAY MODEL
+// ================================
+
+bool DelayModel::parse(const string& text, DelayModel& model) {
+    stringstream ss(text);
+    string kind;
+    if (!(ss >> kind)) return false;
+    transform(kind.begin(), kind.end(), kind.begin(), ::toupper);
+
+    DelayModel parsed;
+    if (kind == "FIXED") {
+        parsed.kind = DelayDistribution::FIXED;
+        if (!(ss >> parsed.mean_ms)) return false;
+    } else if (kind == "LOGNORMAL" || kind == "GAMMA") {
+        parsed.kind = kind == "GAMMA" ? DelayDistribution::GAMMA : DelayDistribution::LOGNORMAL;
+        if (!(ss >> parsed.mean_ms >> parsed.cv) || parsed.cv < 0.0) return false;
+    } else if (kind == "EMPIRICAL") {
+        parsed.kind = DelayDistribution::EMPIRICAL;
+        double value;
+        while (ss >> value) parsed.samples.push_back(value);
+        if (parsed.samples.empty()) return false;
+        sort(parsed.samples.begin(), parsed.samples.end());
+        double sum = 0.0;
+        for (double v : parsed.samples) sum += v;
+        parsed.mean_ms = sum / parsed.samples.size();
+    } else {
+        return false;
+    }
+    if (parsed.mean_ms < 0.0) return false;
+
+    parsed.prepare();
+    model = parsed;
+    return true;
+}
+
+void DelayModel::prepare() {
+    if (kind == DelayDistribution::LOGNORMAL) {
+        sigma = sqrt(log1p(cv * cv));
+        mu = log(max(mean_ms, 1e-9)) - 0.5 * sigma * sigma;
+    } else if (kind == DelayDistribution::GAMMA) {
+        // shape k = 1/cv^2; X ~ mean * (1 - 1/(9k) + z sqrt(1/(9k)))^3
+        double ninth = cv * cv / 9.0;
+        wh_a = 1.0 - ninth;
+        wh_b = sqrt(ninth);
+    }
+}
+
+double DelayModel::quantile(double u) const {
+    switch (kind) {
+        case DelayDistribution::FIXED:
+            return mean_ms;
+        case DelayDistribution::LOGNORMAL:
+            return exp(mu + sigma * inverse_normal_cdf(u));
+        case DelayDistribution::GAMMA: {
+            double base = max(0.0, wh_a + wh_b * inverse_normal_cdf(u));
+            return mean_ms * base * base * base;
+        }
+        case DelayDistribution::EMPIRICAL: {
+            // Piecewise-linear between order statistics
+            double pos = u * (samples.size() - 1);
+            size_t lo = static_cast<size_t>(pos);
+            if (lo + 1 >= samples.size()) return samples.back();
+            return samples[lo] + (pos - lo) * (samples[lo + 1] - samples[lo]);
+        }
+    }
+    return mean_ms;
+}
+
+string DelayModel::describe() const {
+    stringstream ss;
+    switch (kind) {
+        case DelayDistribution::FIXED: ss << "FIXED " << mean_ms; break;
+        case DelayDistribution::LOGNORMAL: ss << "LOGNORMAL " << mean_ms << " " << cv; break;
+        case DelayDistribution::GAMMA: ss << "GAMMA " << mean_ms << " " << cv; break;
+        case DelayDistribution::EMPIRICAL: ss << "EMPIRICAL (" << samples.size() << " samples)"; break;
+    }
+    return ss.str();
+}
+
+// ================================
+// SAMPLING
+// ================================
+
+double inverse_normal_cdf(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    const double low = 0.02425;
+
+    if (p < low) {
+        double q = sqrt(-2.0 * log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    if (p > 1.0 - low) {
+        double q = sqrt(-2.0 * log1p(-p));
+        return -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
+
+void sample_delays(const CounterRng& rng, const vector<DelayModel>& models,
+                   const uint32_t* streams, const uint16_t* model_of, size_t n,
+                   uint32_t tick, RandomPurpose purpose, vector<double>& uniforms, float* out) {
+    uniforms.resize(n);
+    rng.fill_uniform(streams, n, tick, purpose, uniforms.data());
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<float>(models[model_of[i]].quantile(uniforms[i]));
+    }
+}
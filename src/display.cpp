@@ -84,6 +84,7 @@ namespace Display {
     string get_vehicle_color(const string& type) {
         if (type.find("AMB") != string::npos) return RED;
         if (type.find("FIRE") != string::npos) return YELLOW;
+        if (type.find("BUS") != string::npos) return CYAN;
         return GREEN;
     }
 
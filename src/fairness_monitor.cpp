@@ -0,0 +1,149 @@
+#include "fairness_monitor.h"
+
+using namespace std;
+using namespace std::chrono;
+
+// ================================
+// FAIRNESS AND STARVATION
+// ================================
+
+void FairnessMonitor::reset(size_t node_count, size_t class_count) {
+    classes = class_count;
+    streams.assign(node_count * class_count, FairnessStream());
+    queues.assign(node_count * class_count, Queue());
+    class_sums.assign(class_count, RatioSums());
+    epoch = steady_clock::now();
+    next_ticket = 1;
+    starving_now = 0;
+    alarms_raised = 0;
+}
+
+double FairnessMonitor::clock() const {
+    return duration<double>(steady_clock::now() - epoch).count();
+}
+
+AgedTicket FairnessMonitor::join(size_t node, size_t cls) {
+    AgedTicket stamp;
+    size_t index = node * classes + cls;
+    if (cls >= classes || index >= streams.size()) return stamp;
+
+    stamp.ticket = next_ticket++;
+    stamp.since = clock();
+    queues[index].fifo.push_back(Entry{stamp.ticket, stamp.since});
+    FairnessStream& s = streams[index];
+    adjust_ratio(index, s.offered + 1, s.served);
+    return stamp;
+}
+
+void FairnessMonitor::leave(size_t node, size_t cls, const AgedTicket& stamp) {
+    size_t index = node * classes + cls;
+    if (stamp.ticket == 0 || cls >= classes || index >= streams.size()) return;
+
+    double now = clock();
+    double wait = now - stamp.since;
+    FairnessStream& s = streams[index];
+    s.total_wait += wait;
+    if (wait > s.max_wait) s.max_wait = wait;
+    adjust_ratio(index, s.offered, s.served + 1);
+    retire(index, stamp.ticket);
+    evaluate(index, now);
+}
+
+void FairnessMonitor::drop(size_t node, size_t cls, const AgedTicket& stamp) {
+    size_t index = node * classes + cls;
+    if (stamp.ticket == 0 || cls >= classes || index >= streams.size()) return;
+
+    FairnessStream& s = streams[index];
+    adjust_ratio(index, s.offered - 1, s.served);
+    retire(index, stamp.ticket);
+    evaluate(index, clock());
+}
+
+void FairnessMonitor::block(size_t node, size_t cls) {
+    size_t index = node * classes + cls;
+    if (cls < classes && index < streams.size()) streams[index].blocks++;
+}
+
+void FairnessMonitor::check(size_t node) {
+    if (node >= node_count()) return;
+    double now = clock();
+    for (size_t c = 0; c < classes; ++c) evaluate(node * classes + c, now);
+}
+
+double FairnessMonitor::oldest_age(size_t node, size_t cls) {
+    size_t index = node * classes + cls;
+    if (cls >= classes || index >= streams.size() || queues[index].fifo.empty()) return 0.0;
+    return clock() - queues[index].fifo.front().since;
+}
+
+double FairnessMonitor::jain_index(size_t cls) const {
+    if (cls >= classes) return 1.0;
+    return jain(class_sums[cls].sum, class_sums[cls].sum_sq, class_sums[cls].n);
+}
+
+double FairnessMonitor::jain_index() const {
+    RatioSums all;
+    for (const auto& sums : class_sums) {
+        all.sum += sums.sum;
+        all.sum_sq += sums.sum_sq;
+        all.n += sums.n;
+    }
+    return jain(all.sum, all.sum_sq, all.n);
+}
+
+void FairnessMonitor::retire(size_t index, uint64_t ticket) {
+    Queue& q = queues[index];
+    if (!q.fifo.empty() && q.fifo.front().ticket == ticket) {
+        q.fifo.pop_front();
+    } else {
+        q.departed.insert(ticket);
+    }
+    while (!q.fifo.empty() && !q.departed.empty()) {
+        auto it = q.departed.find(q.fifo.front().ticket);
+        if (it == q.departed.end()) break;
+        q.departed.erase(it);
+        q.fifo.pop_front();
+    }
+}
+
+void FairnessMonitor::evaluate(size_t index, double now) {
+    const Queue& q = queues[index];
+    FairnessStream& s = streams[index];
+    bool starving = alarm_seconds > 0.0 && !q.fifo.empty() && now - q.fifo.front().since > alarm_seconds;
+    if (starving == s.starving) return;
+    s.starving = starving;
+    if (starving) {
+        s.alarms++;
+        alarms_raised++;
+        starving_now++;
+    } else {
+        starving_now--;
+    }
+}
+
+// Streams enter the index once they have been offered a vehicle
+void FairnessMonitor::adjust_ratio(size_t index, uint64_t offered, uint64_t served) {
+    FairnessStream& s = streams[index];
+    RatioSums& sums = class_sums[index % classes];
+    if (s.offered > 0) {
+        double old_ratio = static_cast<double>(s.served) / s.offered;
+        sums.sum -= old_ratio;
+        sums.sum_sq -= old_ratio * old_ratio;
+        sums.n--;
+    }
+    s.offered = offered;
+    s.served = served;
+    if (s.offered > 0) {
+        double ratio = static_cast<double>(s.served) / s.offered;
+        sums.sum += ratio;
+        sums.sum_sq += ratio * ratio;
+        sums.n++;
+    }
+}
+
+double FairnessMonitor::jain(double sum, double sum_sq, size_t n) {
+    // No service anywhere is equally unfair to everyone
+    if (n == 0 || sum_sq <= 1e-12) return 1.0;
+    double index = sum * sum / (n * sum_sq);
+    return index > 1.0 ? 1.0 : index;
+}
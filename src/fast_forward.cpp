@@ -0,0 +1,248 @@
+#include "fast_forward.h"
+#include <queue>
+#include <algorithm>
+
+using namespace std;
+
+// ================================
+// NETWORK SNAPSHOT
+// ================================
+
+void NetworkSnapshot::build(const vector<NodeData>& nodes, const SignalController& controller,
+                            const vector<int32_t>& limits, const vector<uint8_t>& priorities) {
+    node_count = nodes.size();
+    signals = &controller;
+    class_limit = limits;
+    class_priority = priorities;
+    capacity.assign(node_count, 0);
+    destination_row.assign(node_count, -1);
+    destinations.clear();
+    vehicles.clear();
+
+    vector<vector<int>> reverse_adjacency(node_count);
+    for (size_t i = 0; i < node_count; ++i) {
+        capacity[i] = nodes[i].capacity;
+        for (int adj : nodes[i].adjacent_nodes) {
+            reverse_adjacency[adj].push_back(static_cast<int>(i));
+        }
+    }
+
+    // Queue contents in service order: emergency queue (by priority), then FIFO
+    for (size_t i = 0; i < node_count; ++i) {
+        priority_queue<Vehicle> emergency = nodes[i].emergency_queue;
+        while (!emergency.empty()) {
+            const Vehicle& v = emergency.top();
+            vehicles.push_back({static_cast<int>(i), v.destination_node, v.type, v.vehicle_id});
+            emergency.pop();
+        }
+        queue<Vehicle> regular = nodes[i].waiting_queue;
+        while (!regular.empty()) {
+            const Vehicle& v = regular.front();
+            vehicles.push_back({static_cast<int>(i), v.destination_node, v.type, v.vehicle_id});
+            regular.pop();
+        }
+    }
+
+    // One routing row per destination in use, from a reverse BFS
+    int rows = 0;
+    for (const auto& v : vehicles) {
+        if (destination_row[v.destination] < 0) {
+            destination_row[v.destination] = rows++;
+            destinations.push_back(v.destination);
+        }
+    }
+    next_hop.assign(static_cast<size_t>(rows) * node_count, -1);
+
+    vector<int> dist(node_count);
+    for (size_t dest = 0; dest < node_count; ++dest) {
+        int row = destination_row[dest];
+        if (row < 0) continue;
+
+        fill(dist.begin(), dist.end(), -1);
+        queue<int> q;
+        dist[dest] = 0;
+        q.push(static_cast<int>(dest));
+        while (!q.empty()) {
+            int curr = q.front();
+            q.pop();
+            for (int prev : reverse_adjacency[curr]) {
+                if (dist[prev] == -1) {
+                    dist[prev] = dist[curr] + 1;
+                    q.push(prev);
+                }
+            }
+        }
+
+        int* hops = &next_hop[static_cast<size_t>(row) * node_count];
+        for (size_t i = 0; i < node_count; ++i) {
+            if (dist[i] <= 0) continue;
+            for (int adj : nodes[i].adjacent_nodes) {
+                if (dist[adj] == dist[i] - 1) {
+                    hops[i] = adj;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// ================================
+// FAST-FORWARD SIMULATOR
+// ================================
+
+void FastForwardSimulator::NodeQueue::pop() {
+    head++;
+    if (head == items.size()) {
+        clear();
+    } else if (head > 32 && head * 2 > items.size()) {
+        items.erase(items.begin(), items.begin() + head);
+        head = 0;
+    }
+}
+
+FastForwardSimulator::FastForwardSimulator(const NetworkSnapshot& network)
+    : net(network),
+      regular_queue(network.node_count),
+      emergency_queue(network.node_count),
+      occupancy(network.node_count, 0),
+      green(network.signals ? network.signals->controller_count() : 0, SignalController::NO_PHASE) {
+    reset();
+}
+
+void FastForwardSimulator::reset() {
+    const size_t n = net.node_count;
+    for (size_t i = 0; i < n; ++i) {
+        regular_queue[i].clear();
+        emergency_queue[i].clear();
+    }
+    fill(occupancy.begin(), occupancy.end(), 0);
+    fill(green.begin(), green.end(), SignalController::NO_PHASE);
+
+    size_t count = net.vehicles.size();
+    vehicle_destination.resize(count);
+    vehicle_class_of.resize(count);
+    vehicle_order.resize(count);
+    vehicle_moved_tick.resize(count);
+    fill(vehicle_moved_tick.begin(), vehicle_moved_tick.end(), static_cast<size_t>(-1));
+    next_order = 0;
+    for (size_t v = 0; v < count; ++v) {
+        const auto& init = net.vehicles[v];
+        vehicle_destination[v] = init.destination;
+        vehicle_class_of[v] = static_cast<uint8_t>(vehicle_class_index(init.type));
+        vehicle_order[v] = init.vehicle_id;
+        next_order = max(next_order, init.vehicle_id + 1);
+        occupancy[init.node]++;
+        enqueue(static_cast<int>(v), init.node);
+    }
+
+    current_tick = 0;
+    vehicles_in_network = static_cast<int>(count);
+    vehicles_completed = 0;
+    total_vehicle_ticks = 0;
+}
+
+int FastForwardSimulator::add_vehicle(int node, int destination, VehicleType type) {
+    if (node < 0 || node >= static_cast<int>(net.node_count) || node == destination) return -1;
+    if (destination < 0 || net.destination_row[destination] < 0) return -1;
+    size_t cls = vehicle_class_index(type);
+    if (occupancy[node] >= net.class_limit[node * VEHICLE_CLASS_COUNT + cls]) return -1;
+
+    int v = static_cast<int>(vehicle_destination.size());
+    vehicle_destination.push_back(destination);
+    vehicle_class_of.push_back(static_cast<uint8_t>(cls));
+    vehicle_order.push_back(next_order++);
+    vehicle_moved_tick.push_back(current_tick);   // enters service next tick
+    occupancy[node]++;
+    vehicles_in_network++;
+    enqueue(v, node);
+    return v;
+}
+
+// Vehicle::operator< for the emergency queue: higher rank at this node
+// first, then the older vehicle
+bool FastForwardSimulator::served_after(int a, int b, int node) const {
+    const uint8_t* rank = &net.class_priority[static_cast<size_t>(node) * VEHICLE_CLASS_COUNT];
+    if (rank[vehicle_class_of[a]] != rank[vehicle_class_of[b]]) {
+        return rank[vehicle_class_of[a]] < rank[vehicle_class_of[b]];
+    }
+    return vehicle_order[a] > vehicle_order[b];
+}
+
+void FastForwardSimulator::enqueue(int vehicle, int node) {
+    if (!VEHICLE_CLASSES[vehicle_class_of[vehicle]].emergency) {
+        regular_queue[node].push(vehicle);
+        return;
+    }
+    // Emergency queues hold a few vehicles; keep them sorted by insertion
+    NodeQueue& q = emergency_queue[node];
+    size_t pos = q.items.size();
+    while (pos > q.head && served_after(q.items[pos - 1], vehicle, node)) --pos;
+    q.items.insert(q.items.begin() + pos, vehicle);
+}
+
+void FastForwardSimulator::apply_plan(const SignalPlan& plan) {
+    for (size_t c = 0; c < green.size(); ++c) {
+        green[c] = net.signals->plan_green_at(plan, c, current_tick);
+    }
+}
+
+int FastForwardSimulator::queue_length(size_t node) const {
+    return static_cast<int>(regular_queue[node].size() + emergency_queue[node].size());
+}
+
+void FastForwardSimulator::step() {
+    const size_t n = net.node_count;
+
+    for (size_t i = 0; i < n; ++i) {
+        bool is_emergency = !emergency_queue[i].empty();
+        NodeQueue& q = is_emergency ? emergency_queue[i] : regular_queue[i];
+        if (q.empty()) continue;
+
+        int v = q.front();
+        if (vehicle_moved_tick[v] == current_tick) continue;   // arrived this tick
+
+        int dest = vehicle_destination[v];
+        int next = net.next_hop[static_cast<size_t>(net.destination_row[dest]) * n + i];
+
+        bool can_move = next >= 0;
+        if (can_move && !is_emergency && net.signals) {
+            int c = net.signals->controller_of(next);
+            can_move = c < 0 || green[c] == SignalController::NO_PHASE || green[c] == static_cast<int>(i);
+        }
+        if (can_move) {
+            can_move = occupancy[next] < net.class_limit[static_cast<size_t>(next) * VEHICLE_CLASS_COUNT +
+                                                         vehicle_class_of[v]];
+        }
+
+        q.pop();
+        if (!can_move) {
+            // Blocked or red: requeued as the live engine does, which puts a
+            // regular vehicle at the back and an emergency one back in rank
+            enqueue(v, static_cast<int>(i));
+            continue;
+        }
+
+        occupancy[i]--;
+        vehicle_moved_tick[v] = current_tick;
+        if (next == dest) {
+            vehicles_in_network--;
+            vehicles_completed++;
+        } else {
+            occupancy[next]++;
+            enqueue(v, next);
+        }
+    }
+
+    total_vehicle_ticks += vehicles_in_network;
+    current_tick++;
+}
+
+double FastForwardSimulator::evaluate(const SignalPlan* plan, size_t horizon_ticks) {
+    reset();
+    while (current_tick < horizon_ticks && vehicles_in_network > 0) {
+        if (plan) apply_plan(*plan);
+        step();
+    }
+    return static_cast<double>(total_vehicle_ticks) +
+           static_cast<double>(vehicles_in_network) * horizon_ticks;
+}
@@ -0,0 +1,255 @@
+#include "flow_model.h"
+#include <queue>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+void FlowModel::build(const vector<NodeData>& nodes) {
+    node_count = nodes.size();
+    capacity.assign(node_count, 0);
+    external.assign(node_count, false);
+    external_load.assign(node_count, 0);
+    edge_offset.assign(node_count + 1, 0);
+    edge_from.clear();
+    edge_to.clear();
+    reverse_adjacency.assign(node_count, vector<int>());
+
+    for (size_t i = 0; i < node_count; ++i) {
+        capacity[i] = nodes[i].capacity;
+        edge_offset[i] = static_cast<int>(edge_to.size());
+        for (int adj : nodes[i].adjacent_nodes) {
+            edge_from.push_back(static_cast<int>(i));
+            edge_to.push_back(adj);
+            reverse_adjacency[adj].push_back(static_cast<int>(i));
+        }
+    }
+    edge_offset[node_count] = static_cast<int>(edge_to.size());
+
+    route_index.clear();
+    route_destination.clear();
+    route_edges.clear();
+    stock.assign(node_count, vector<FlowStock>());
+    transfers.clear();
+
+    edge_through.assign(edge_to.size(), 0.0);
+    edge_exit.assign(edge_to.size(), 0.0);
+    edge_flow.assign(edge_to.size(), 0.0);
+    stranded.assign(node_count, 0.0);
+    occupancy.assign(node_count, 0.0);
+    send_ratio.assign(node_count, 0.0);
+    inflow_demand.assign(node_count, 0.0);
+    accept_ratio.assign(node_count, 1.0);
+    totals = FlowKpis{};
+}
+
+void FlowModel::set_external_nodes(const vector<bool>& mask) {
+    for (size_t i = 0; i < node_count; ++i) {
+        external[i] = i < mask.size() && mask[i];
+    }
+}
+
+uint32_t FlowModel::route_for(int destination) {
+    auto it = route_index.find(destination);
+    if (it != route_index.end()) return it->second;
+
+    uint32_t route = static_cast<uint32_t>(route_destination.size());
+    route_index[destination] = route;
+    route_destination.push_back(destination);
+    route_edges.resize((route + 1) * node_count, -1);
+    compute_routes(route);
+    return route;
+}
+
+void FlowModel::compute_routes(uint32_t route) {
+    // Reverse BFS from the destination gives hop distances; each node then
+    // forwards to its first neighbor that is one hop closer.
+    int dest = route_destination[route];
+    vector<int> dist(node_count, -1);
+    queue<int> q;
+    dist[dest] = 0;
+    q.push(dest);
+    while (!q.empty()) {
+        int curr = q.front();
+        q.pop();
+        for (int prev : reverse_adjacency[curr]) {
+            if (dist[prev] == -1) {
+                dist[prev] = dist[curr] + 1;
+                q.push(prev);
+            }
+        }
+    }
+
+    int* edges = &route_edges[route * node_count];
+    for (size_t i = 0; i < node_count; ++i) {
+        edges[i] = -1;
+        if (static_cast<int>(i) == dest || dist[i] <= 0) continue;
+        for (int e = edge_offset[i]; e < edge_offset[i + 1]; ++e) {
+            if (dist[edge_to[e]] == dist[i] - 1) {
+                edges[i] = e;
+                break;
+            }
+        }
+    }
+}
+
+// Keeps the per-edge arrays equal to the sum of the breakdown entries
+void FlowModel::add_edge_stock(int node, const FlowStock& entry, double amount) {
+    int e = route_edge(entry.route, node);
+    if (e < 0) {
+        stranded[node] += amount;
+    } else if (edge_to[e] == route_destination[entry.route]) {
+        edge_exit[e] += amount;
+    } else {
+        edge_through[e] += amount;
+    }
+}
+
+void FlowModel::deposit(int node, const FlowStock& entry) {
+    add_edge_stock(node, entry, entry.amount);
+    for (FlowStock& existing : stock[node]) {
+        if (existing.route == entry.route && existing.type == entry.type) {
+            existing.amount += entry.amount;
+            return;
+        }
+    }
+    stock[node].push_back(entry);
+}
+
+void FlowModel::complete(const FlowStock& entry, double amount) {
+    if (vehicle_class(entry.type).emergency) {
+        totals.completed_emergency += amount;
+    } else {
+        totals.completed_regular += amount;
+    }
+}
+
+void FlowModel::add_stock(int node, int destination, VehicleType type, double amount) {
+    if (node < 0 || node >= static_cast<int>(node_count)) return;
+    if (destination < 0 || destination >= static_cast<int>(node_count)) return;
+    FlowStock entry{route_for(destination), type, amount};
+    if (node == destination) {
+        complete(entry, amount);
+        return;
+    }
+    deposit(node, entry);
+    occupancy[node] += amount;
+}
+
+void FlowModel::add_vehicles_from_queues(const vector<NodeData>& nodes) {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        queue<Vehicle> regular = nodes[i].waiting_queue;
+        while (!regular.empty()) {
+            add_stock(static_cast<int>(i), regular.front().destination_node, regular.front().type, 1.0);
+            regular.pop();
+        }
+        priority_queue<Vehicle> emergency = nodes[i].emergency_queue;
+        while (!emergency.empty()) {
+            add_stock(static_cast<int>(i), emergency.top().destination_node, emergency.top().type, 1.0);
+            emergency.pop();
+        }
+    }
+}
+
+void FlowModel::step(double dt) {
+    const size_t n = node_count;
+    const size_t edges = edge_to.size();
+    const double service = service_rate * dt;
+
+    // 1. Sending ratio from occupancy (kept current between sweeps)
+    double in_network = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double occ = occupancy[i];
+        in_network += occ;
+        send_ratio[i] = external[i] ? 0.0 : (occ > service ? service / occ : 1.0);
+    }
+
+    // 2. Through demand arriving at each node; exiting stock needs no storage
+    fill(inflow_demand.begin(), inflow_demand.end(), 0.0);
+    for (size_t e = 0; e < edges; ++e) {
+        inflow_demand[edge_to[e]] += edge_through[e] * send_ratio[edge_from[e]];
+    }
+
+    // 3. Receiving ratio from remaining storage
+    for (size_t j = 0; j < n; ++j) {
+        double space = max(0.0, capacity[j] - occupancy[j] - external_load[j]);
+        double demand = inflow_demand[j];
+        accept_ratio[j] = demand > space ? space / demand : 1.0;
+    }
+
+    // 4. Per-edge flow from start-of-sweep stock; occupancy follows it, and
+    // the moved through stock is put on its next edge by the deposits below
+    double moved_total = 0.0;
+    for (size_t e = 0; e < edges; ++e) {
+        int from = edge_from[e];
+        int to = edge_to[e];
+        double send = send_ratio[from];
+        double through = edge_through[e] * send * accept_ratio[to];
+        double exiting = edge_exit[e] * send;
+        edge_through[e] -= through;
+        edge_exit[e] -= exiting;
+        edge_flow[e] = through + exiting;
+        occupancy[from] -= through + exiting;
+        occupancy[to] += through;
+        moved_total += through + exiting;
+    }
+
+    // 5. Destination breakdown: each entry moves by its edge's ratio. Moved
+    // stock is deposited after the pass, so it is not forwarded again within
+    // the sweep; deposits add it to the next edge's stock.
+    transfers.clear();
+    for (size_t i = 0; i < n; ++i) {
+        double send = send_ratio[i];
+        if (send <= 0.0) continue;
+        for (FlowStock& entry : stock[i]) {
+            int e = route_edge(entry.route, i);
+            if (e < 0) continue;
+            int j = edge_to[e];
+            bool exits = j == route_destination[entry.route];
+            double moved = entry.amount * (exits ? send : send * accept_ratio[j]);
+            if (moved <= 0.0) continue;
+            entry.amount -= moved;
+            if (exits) {
+                complete(entry, moved);
+            } else {
+                transfers.push_back(FlowTransfer{j, FlowStock{entry.route, entry.type, moved}});
+            }
+        }
+        auto& entries = stock[i];
+        entries.erase(remove_if(entries.begin(), entries.end(),
+                                [](const FlowStock& entry) { return entry.amount <= 0.0; }),
+                      entries.end());
+    }
+    for (const FlowTransfer& t : transfers) deposit(t.node, t.stock);
+
+    totals.vehicles_moved += moved_total;
+    totals.vehicle_seconds += in_network * dt;
+    totals.simulated_time += dt;
+    totals.sweeps++;
+}
+
+double FlowModel::total_stock() const {
+    double total = 0.0;
+    for (double occ : occupancy) total += occ;
+    return total;
+}
+
+vector<double> FlowModel::edge_densities() const {
+    vector<double> density(edge_to.size(), 0.0);
+    for (size_t e = 0; e < density.size(); ++e) {
+        int cap = capacity[edge_from[e]];
+        density[e] = cap > 0 ? (edge_through[e] + edge_exit[e]) / cap : 0.0;
+    }
+    return density;
+}
+
+void FlowModel::export_stats(SystemStats& stats) const {
+    int regular = static_cast<int>(llround(totals.completed_regular));
+    int emergency = static_cast<int>(llround(totals.completed_emergency));
+    stats.total_moves += static_cast<int>(llround(totals.vehicles_moved));
+    stats.total_vehicles_processed += regular;
+    stats.emergency_vehicles_processed += emergency;
+    stats.successful_routes += regular + emergency;
+    stats.total_journey_time += totals.vehicle_seconds;
+    stats.step_count += static_cast<int>(totals.sweeps);
+}
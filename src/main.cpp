@@ -1,11 +1,58 @@
 #include "traffic_network.h"
 #include "display.h"
+#include "state_export.h"
 #include <iostream>
 #include <exception>
+#include <thread>
+#include <chrono>
 
 using namespace std;
 
+// Minimal viewer for a running simulation's STATE_EXPORT region
+static int watch_shared_state(const string& name) {
+    SharedStateReader reader;
+    for (int attempt = 0; attempt < 50 && !reader.open(name); ++attempt) {
+        this_thread::sleep_for(chrono::milliseconds(100));
+    }
+    if (reader.node_count() == 0) {
+        cout << Display::ERROR_ICON << " No shared state named " << name << endl;
+        return 1;
+    }
+
+    SharedFrameHeader frame{};
+    vector<int32_t> occupancy, queue_depth;
+    vector<float> edge_flow;
+    uint64_t last_tick = UINT64_MAX;
+    int idle_polls = 0;
+    while (idle_polls < 20) {
+        if (reader.read_latest(frame, occupancy, queue_depth, edge_flow) && frame.tick != last_tick) {
+            last_tick = frame.tick;
+            idle_polls = 0;
+            cout << "tick " << frame.tick << " t=" << frame.simulated_seconds << "s |";
+            for (size_t i = 0; i < occupancy.size(); ++i) {
+                cout << " " << static_cast<char>('A' + i) << ":" << occupancy[i] << "/" << queue_depth[i];
+            }
+            float moved = 0.0f;
+            for (float f : edge_flow) moved += f;
+            cout << " | moved " << moved << endl;
+        } else {
+            idle_polls++;
+        }
+        this_thread::sleep_for(chrono::milliseconds(250));
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
+    if (argc > 2 && string(argv[1]) == "--watch") {
+        return watch_shared_state(argv[2]);
+    }
+    if (argc > 1 && string(argv[1]) == "--check") {
+        // Non-interactive differential check with the default scenario set
+        TrafficNetwork network;
+        return network.run_differential_check() ? 0 : 1;
+    }
+
     try {
         TrafficNetwork network;
 
@@ -0,0 +1,260 @@
+#include "map_matching.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+using namespace std;
+
+static constexpr double NO_SCORE = -numeric_limits<double>::infinity();
+
+MapMatcher::MapMatcher(const vector<NodeData>& nodes, const SpatialIndex& spatial_index,
+                       const MapMatchParams& match_params)
+    : index(spatial_index), params(match_params), node_count(nodes.size()),
+      row_ready(new once_flag[nodes.size()]), rows(nodes.size()) {
+    adjacency_start.assign(node_count + 1, 0);
+    for (size_t i = 0; i < node_count; ++i) {
+        adjacency_start[i + 1] = adjacency_start[i] + static_cast<uint32_t>(nodes[i].adjacent_nodes.size());
+    }
+    adjacency.reserve(adjacency_start.back());
+    edge_length.reserve(adjacency_start.back());
+    double total_length = 0.0;
+    for (size_t i = 0; i < node_count; ++i) {
+        for (int j : nodes[i].adjacent_nodes) {
+            double length = index.distance_between(static_cast<int>(i), j);
+            adjacency.push_back(j);
+            edge_length.push_back(static_cast<float>(length));
+            total_length += length;
+        }
+    }
+
+    double mean_edge = adjacency.empty() ? 1.0 : total_length / adjacency.size();
+    if (mean_edge <= 0.0) mean_edge = 1.0;
+    if (params.gps_sigma <= 0.0) params.gps_sigma = 0.25 * mean_edge;
+    if (params.search_radius <= 0.0) params.search_radius = 2.0 * mean_edge;
+    if (params.transition_beta <= 0.0) params.transition_beta = mean_edge;
+    if (params.max_route <= 0.0) params.max_route = 10.0 * mean_edge;
+    params.max_candidates = max<size_t>(1, params.max_candidates);
+}
+
+// ================================
+// ROUTE CACHE
+// ================================
+
+const MapMatcher::RouteRow& MapMatcher::route_from(int source) const {
+    call_once(row_ready[source], [this, source]() {
+        // Bounded Dijkstra; scratch arrays are per thread and reset through
+        // the settled list, so a row costs only what it reaches
+        thread_local vector<float> best;
+        thread_local vector<int> via;
+        if (best.size() != node_count) {
+            best.assign(node_count, numeric_limits<float>::infinity());
+            via.assign(node_count, -1);
+        }
+        vector<int> reached;
+        const float limit = static_cast<float>(params.max_route);
+
+        priority_queue<pair<float, int>, vector<pair<float, int>>, greater<pair<float, int>>> open;
+        best[source] = 0.0f;
+        reached.push_back(source);
+        open.emplace(0.0f, source);
+        while (!open.empty()) {
+            auto [dist, curr] = open.top();
+            open.pop();
+            if (dist > best[curr]) continue;
+            for (uint32_t e = adjacency_start[curr]; e < adjacency_start[curr + 1]; ++e) {
+                int next = adjacency[e];
+                float through = dist + edge_length[e];
+                if (through > limit || through >= best[next]) continue;
+                if (isinf(best[next])) reached.push_back(next);
+                best[next] = through;
+                via[next] = curr;
+                open.emplace(through, next);
+            }
+        }
+
+        sort(reached.begin(), reached.end());
+        RouteRow& row = rows[source];
+        row.node = reached;
+        row.distance.reserve(reached.size());
+        row.parent.reserve(reached.size());
+        for (int node : reached) {
+            row.distance.push_back(best[node]);
+            row.parent.push_back(via[node]);
+            best[node] = numeric_limits<float>::infinity();
+            via[node] = -1;
+        }
+    });
+    return rows[source];
+}
+
+int MapMatcher::row_slot(const RouteRow& row, int target) {
+    auto it = lower_bound(row.node.begin(), row.node.end(), target);
+    return it != row.node.end() && *it == target ? static_cast<int>(it - row.node.begin()) : -1;
+}
+
+// Appends the route after `from` up to and including `to`; just `to` if
+// there is no route, which leaves a gap the replay reroutes across.
+void MapMatcher::append_route(int from, int to, vector<int>& out) const {
+    const RouteRow& row = route_from(from);
+    if (row_slot(row, to) < 0) {
+        out.push_back(to);
+        return;
+    }
+    size_t mark = out.size();
+    for (int node = to; node != from; node = row.parent[row_slot(row, node)]) {
+        out.push_back(node);
+    }
+    reverse(out.begin() + mark, out.end());
+}
+
+// ================================
+// VITERBI DECODING
+// ================================
+
+MatchedTrip MapMatcher::match(const GpsTrace& trace) const {
+    MatchedTrip trip;
+    trip.trace_id = trace.trace_id;
+
+    // Flattened lattice: step t owns candidates [step_start[t], step_start[t + 1])
+    vector<uint32_t> step_start{0};
+    vector<size_t> step_ping;
+    vector<int> candidate;
+    vector<double> emission;
+    vector<double> score;
+    vector<int> back;           // best predecessor, -1 where the chain restarts
+    vector<int> nearby;
+    const double inv_two_var = 1.0 / (2.0 * params.gps_sigma * params.gps_sigma);
+
+    for (size_t p = 0; p < trace.pings.size(); ++p) {
+        const GeoPoint& where = trace.pings[p].position;
+        index.k_nearest(where, params.max_candidates, nearby);
+        uint32_t begin = static_cast<uint32_t>(candidate.size());
+        for (int node : nearby) {
+            double snap = index.distance(where, index.position_of(node));
+            if (snap > params.search_radius) break;     // closest first
+            candidate.push_back(node);
+            emission.push_back(-snap * snap * inv_two_var);
+            score.push_back(NO_SCORE);
+            back.push_back(-1);
+        }
+        uint32_t end = static_cast<uint32_t>(candidate.size());
+        if (begin == end) continue;
+        trip.matched_pings++;
+
+        bool linked = false;
+        if (!step_ping.empty()) {
+            size_t prev = step_ping.size() - 1;
+            double straight = index.distance(trace.pings[step_ping[prev]].position, where);
+            for (uint32_t i = step_start[prev]; i < step_start[prev + 1]; ++i) {
+                if (score[i] == NO_SCORE) continue;
+                const RouteRow& row = route_from(candidate[i]);
+                for (uint32_t j = begin; j < end; ++j) {
+                    int slot = row_slot(row, candidate[j]);
+                    if (slot < 0) continue;
+                    float route = row.distance[slot];
+                    double total = score[i] - fabs(route - straight) / params.transition_beta;
+                    if (total > score[j]) {
+                        score[j] = total;
+                        back[j] = static_cast<int>(i);
+                    }
+                }
+            }
+            for (uint32_t j = begin; j < end; ++j) {
+                if (back[j] >= 0) {
+                    score[j] += emission[j];
+                    linked = true;
+                }
+            }
+            if (!linked) trip.breaks++;
+        }
+        if (!linked) {
+            for (uint32_t j = begin; j < end; ++j) score[j] = emission[j];
+        }
+        step_ping.push_back(p);
+        step_start.push_back(end);
+    }
+
+    if (step_ping.empty()) return trip;
+
+    // Backtrack; at a restart continue from the best end of the earlier chain
+    auto best_of = [&](size_t step) {
+        uint32_t best = step_start[step];
+        for (uint32_t j = best + 1; j < step_start[step + 1]; ++j) {
+            if (score[j] > score[best]) best = j;
+        }
+        return static_cast<int>(best);
+    };
+    vector<int> chosen(step_ping.size());
+    int cur = best_of(step_ping.size() - 1);
+    for (size_t t = step_ping.size(); t-- > 0;) {
+        chosen[t] = candidate[cur];
+        cur = back[cur];
+        if (cur < 0 && t > 0) cur = best_of(t - 1);
+    }
+
+    trip.nodes.push_back(chosen[0]);
+    for (size_t t = 1; t < chosen.size(); ++t) {
+        if (chosen[t] != trip.nodes.back()) append_route(trip.nodes.back(), chosen[t], trip.nodes);
+    }
+    return trip;
+}
+
+void MapMatcher::match_all(const vector<GpsTrace>& traces, vector<MatchedTrip>& trips, ThreadPool& pool) const {
+    trips.assign(traces.size(), MatchedTrip{});
+    pool.parallel_for(0, traces.size(), [&](size_t t) {
+        trips[t] = match(traces[t]);
+    }, 4);
+}
+
+// ================================
+// TRACE AND TRIP FILES
+// ================================
+
+bool MapMatcher::load_traces(const string& path, bool geographic, vector<GpsTrace>& traces) {
+    ifstream file(path);
+    if (!file.is_open()) return false;
+
+    traces.clear();
+    unordered_map<int, size_t> trace_index;
+    string line;
+    while (getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        replace(line.begin(), line.end(), ',', ' ');
+        stringstream ss(line);
+        int trace_id;
+        double timestamp, a, b;
+        if (!(ss >> trace_id >> timestamp >> a >> b)) continue;
+
+        auto found = trace_index.find(trace_id);
+        if (found == trace_index.end()) {
+            found = trace_index.emplace(trace_id, traces.size()).first;
+            traces.push_back(GpsTrace{trace_id, {}});
+        }
+        GeoPoint position = geographic ? GeoPoint{b, a} : GeoPoint{a, b};
+        traces[found->second].pings.push_back(GpsPing{timestamp, position});
+    }
+
+    for (auto& trace : traces) {
+        stable_sort(trace.pings.begin(), trace.pings.end(),
+                    [](const GpsPing& x, const GpsPing& y) { return x.timestamp < y.timestamp; });
+    }
+    return true;
+}
+
+bool MapMatcher::save_trips(const string& path, const vector<MatchedTrip>& trips) {
+    ofstream file(path);
+    if (!file.is_open()) return false;
+
+    file << "# Matched trips: trace_id: node sequence\n";
+    for (const auto& trip : trips) {
+        if (trip.nodes.empty()) continue;
+        file << trip.trace_id << ":";
+        for (int node : trip.nodes) file << ' ' << static_cast<char>('A' + node);
+        file << '\n';
+    }
+    return static_cast<bool>(file);
+}
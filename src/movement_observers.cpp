@@ -0,0 +1,55 @@
+#include "movement_observers.h"
+#include "display.h"
+#include <iostream>
+
+using namespace std;
+
+static char node_letter(size_t node) {
+    return static_cast<char>('A' + node);
+}
+
+void NarratingMovementObserver::on_vehicle_selected(const Vehicle& vehicle, size_t node) {
+    cout << Display::INFO_ICON << " Processing vehicle "
+         << Display::get_vehicle_color(vehicle.to_string()) << vehicle.to_string()
+         << Display::RESET << " at Node " << Display::BOLD << node_letter(node) << Display::RESET;
+    cout << " (Destination: " << Display::BOLD << node_letter(vehicle.destination_node)
+         << Display::RESET << ")" << endl;
+}
+
+void NarratingMovementObserver::on_no_path(const Vehicle& /* vehicle */, size_t /* node */) {
+    cout << Display::WARNING_ICON << " No path available - returning to queue" << endl;
+}
+
+void NarratingMovementObserver::on_blocked(const Vehicle& /* vehicle */, int next_node) {
+    cout << Display::WARNING_ICON << " Destination Node "
+         << node_letter(next_node) << " is at capacity - blocking" << endl;
+}
+
+void NarratingMovementObserver::on_red_signal(const Vehicle& /* vehicle */, int next_node) {
+    cout << Display::WARNING_ICON << " Signal at Node "
+         << node_letter(next_node) << " is red for this approach - waiting" << endl;
+}
+
+void NarratingMovementObserver::on_move(const Vehicle& vehicle, size_t from_node, int to_node) {
+    cout << Display::MOVE_ICON << " " << Display::BOLD
+         << Display::get_vehicle_color(vehicle.to_string()) << vehicle.to_string()
+         << Display::RESET << " moves from Node " << Display::BOLD << node_letter(from_node)
+         << Display::RESET << " to Node " << Display::BOLD << node_letter(to_node) << Display::RESET;
+}
+
+void NarratingMovementObserver::on_destination_reached(const Vehicle& /* vehicle */) {
+    cout << " " << Display::SUCCESS_ICON << Display::GREEN << " DESTINATION REACHED!"
+         << Display::RESET << endl;
+}
+
+void NarratingMovementObserver::on_enqueued(const Vehicle& vehicle, int node) {
+    cout << endl;
+    cout << Display::INFO_ICON << " Vehicle " << vehicle.to_string()
+         << " added to Node " << node_letter(node) << " queue" << endl;
+}
+
+void NarratingMovementObserver::on_bounced(const Vehicle& vehicle, size_t node) {
+    cout << endl;
+    cout << Display::WARNING_ICON << " Vehicle " << vehicle.to_string()
+         << " could not enter - returned to Node " << node_letter(node) << endl;
+}
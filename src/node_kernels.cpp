@@ -0,0 +1,163 @@
+#include "node_kernels.h"
+#include <algorithm>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define NODE_KERNELS_HAVE_AVX2 1
+#endif
+
+using namespace std;
+
+// Fresh allocations, so no page is touched before the owners write them
+template<class T>
+static void reallocate(node_array<T>& array, size_t n) {
+    node_array<T>().swap(array);
+    array.resize(n);
+}
+
+void NodeStateArrays::resize(size_t n) {
+    size_t words = (n + NodeKernels::BLOCK - 1) / NodeKernels::BLOCK;
+    reallocate(current_vehicles, n);
+    reallocate(capacity, n);
+    reallocate(waiting, n);
+    reallocate(emergency, n);
+    reallocate(utilization, n);
+    reallocate(status, n);
+    reallocate(headroom, n);
+    reallocate(work_mask, words);
+    reallocate(emergency_mask, words);
+}
+
+namespace NodeKernels {
+
+// Thresholds match NodeData::get_status (50/75/90 percent) but are evaluated
+// in exact integer arithmetic so the scalar and SIMD paths always agree.
+NodeStatus classify(int current, int capacity) {
+    if (capacity <= 0) return NodeStatus::LOW;
+    if (current * 10 >= capacity * 9) return NodeStatus::CRITICAL;
+    if (current * 4 >= capacity * 3) return NodeStatus::HIGH;
+    if (current * 2 >= capacity) return NodeStatus::NORMAL;
+    return NodeStatus::LOW;
+}
+
+const char* status_name(NodeStatus status) {
+    switch (status) {
+        case NodeStatus::CRITICAL: return "CRITICAL";
+        case NodeStatus::HIGH: return "HIGH";
+        case NodeStatus::NORMAL: return "NORMAL";
+        default: return "LOW";
+    }
+}
+
+static inline void update_one(NodeStateArrays& s, size_t i) {
+    int32_t cur = s.current_vehicles[i];
+    int32_t cap = s.capacity[i];
+    s.utilization[i] = cap > 0 ? static_cast<float>(cur) / static_cast<float>(cap) * 100.0f : 0.0f;
+    s.status[i] = static_cast<uint8_t>(classify(cur, cap));
+    s.headroom[i] = cap - cur;
+
+    uint64_t bit = 1ULL << (i & 63);
+    if (s.waiting[i] + s.emergency[i] > 0) s.work_mask[i >> 6] |= bit;
+    if (s.emergency[i] > 0) s.emergency_mask[i >> 6] |= bit;
+}
+
+void update_scalar(NodeStateArrays& s, size_t begin, size_t end) {
+    end = min(end, s.size());
+    for (size_t w = begin / BLOCK; w < (end + BLOCK - 1) / BLOCK; ++w) {
+        s.work_mask[w] = 0;
+        s.emergency_mask[w] = 0;
+    }
+    for (size_t i = begin; i < end; ++i) {
+        update_one(s, i);
+    }
+}
+
+#ifdef NODE_KERNELS_HAVE_AVX2
+__attribute__((target("avx2")))
+static void update_avx2(NodeStateArrays& s, size_t begin, size_t end) {
+    end = min(end, s.size());
+    for (size_t w = begin / BLOCK; w < (end + BLOCK - 1) / BLOCK; ++w) {
+        s.work_mask[w] = 0;
+        s.emergency_mask[w] = 0;
+    }
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi32(-1);
+    const __m256 hundred = _mm256_set1_ps(100.0f);
+    alignas(32) int32_t status_lanes[8];
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s.current_vehicles[i]));
+        __m256i cap = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s.capacity[i]));
+        __m256i wait = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s.waiting[i]));
+        __m256i emer = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s.emergency[i]));
+
+        __m256i has_cap = _mm256_cmpgt_epi32(cap, zero);
+
+        // Utilization; lanes without capacity are masked to 0
+        __m256 util = _mm256_mul_ps(_mm256_div_ps(_mm256_cvtepi32_ps(cur), _mm256_cvtepi32_ps(cap)), hundred);
+        util = _mm256_and_ps(util, _mm256_castsi256_ps(has_cap));
+        _mm256_storeu_ps(&s.utilization[i], util);
+
+        // Status = number of thresholds reached (a >= b  <=>  !(b > a))
+        __m256i crit = _mm256_andnot_si256(
+            _mm256_cmpgt_epi32(_mm256_mullo_epi32(cap, _mm256_set1_epi32(9)),
+                               _mm256_mullo_epi32(cur, _mm256_set1_epi32(10))), ones);
+        __m256i high = _mm256_andnot_si256(
+            _mm256_cmpgt_epi32(_mm256_mullo_epi32(cap, _mm256_set1_epi32(3)),
+                               _mm256_mullo_epi32(cur, _mm256_set1_epi32(4))), ones);
+        __m256i normal = _mm256_andnot_si256(
+            _mm256_cmpgt_epi32(cap, _mm256_add_epi32(cur, cur)), ones);
+        __m256i level = _mm256_sub_epi32(zero, _mm256_add_epi32(crit, _mm256_add_epi32(high, normal)));
+        level = _mm256_and_si256(level, has_cap);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(status_lanes), level);
+        for (int lane = 0; lane < 8; ++lane) {
+            s.status[i + lane] = static_cast<uint8_t>(status_lanes[lane]);
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&s.headroom[i]), _mm256_sub_epi32(cap, cur));
+
+        // Work and emergency masks: one bit per lane
+        uint64_t work_bits = static_cast<uint32_t>(_mm256_movemask_ps(
+            _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_add_epi32(wait, emer), zero))));
+        uint64_t emer_bits = static_cast<uint32_t>(_mm256_movemask_ps(
+            _mm256_castsi256_ps(_mm256_cmpgt_epi32(emer, zero))));
+        s.work_mask[i >> 6] |= work_bits << (i & 63);
+        s.emergency_mask[i >> 6] |= emer_bits << (i & 63);
+    }
+
+    for (; i < end; ++i) {
+        update_one(s, i);
+    }
+}
+#endif
+
+bool avx2_available() {
+#ifdef NODE_KERNELS_HAVE_AVX2
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+const char* active_kernel_name() {
+    return avx2_available() ? "AVX2" : "scalar";
+}
+
+void update(NodeStateArrays& state, size_t begin, size_t end) {
+#ifdef NODE_KERNELS_HAVE_AVX2
+    if (avx2_available()) {
+        update_avx2(state, begin, end);
+        return;
+    }
+#endif
+    update_scalar(state, begin, end);
+}
+
+void update(NodeStateArrays& state) {
+    update(state, 0, state.size());
+}
+
+} // namespace NodeKernels
@@ -0,0 +1,181 @@
+#include "reference_engine.h"
+#include "philox.h"
+#include <algorithm>
+#include <random>
+#include <queue>
+
+using namespace std;
+
+// ================================
+// DIFFERENTIAL SCENARIOS
+// ================================
+
+DifferentialScenario DifferentialScenario::random(uint64_t seed) {
+    PhiloxEngine rng(seed, 0, RandomPurpose::SCENARIO);
+    DifferentialScenario scenario;
+    scenario.seed = seed;
+
+    int n = uniform_int_distribution<int>(4, 26)(rng);
+    double chord_probability = uniform_real_distribution<double>(0.05, 0.35)(rng);
+    vector<vector<bool>> edge(n, vector<bool>(n, false));
+
+    // A ring keeps most destinations reachable; random chords add choices,
+    // and an occasional missing ring edge leaves some unreachable
+    for (int i = 0; i < n; ++i) {
+        if (uniform_real_distribution<double>(0, 1)(rng) < 0.95) edge[i][(i + 1) % n] = true;
+        for (int j = 0; j < n; ++j) {
+            if (j != i && uniform_real_distribution<double>(0, 1)(rng) < chord_probability) edge[i][j] = true;
+        }
+    }
+
+    scenario.adjacency.assign(n, vector<int>());
+    scenario.capacity.resize(n);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            if (edge[i][j]) scenario.adjacency[i].push_back(j);
+        }
+        scenario.capacity[i] = uniform_int_distribution<int>(1, 6)(rng);
+    }
+
+    int next_id = 1;
+    for (int i = 0; i < n; ++i) {
+        int count = uniform_int_distribution<int>(0, scenario.capacity[i])(rng);
+        for (int k = 0; k < count; ++k) {
+            int roll = uniform_int_distribution<int>(0, 9)(rng);
+            VehicleType type = roll == 0 ? VehicleType::AMBULANCE :
+                               roll == 1 ? VehicleType::FIRE_TRUCK : VehicleType::REGULAR;
+            int destination = uniform_int_distribution<int>(0, n - 2)(rng);
+            if (destination >= i) destination++;
+            scenario.vehicles.push_back({next_id++, type, i, destination});
+        }
+    }
+    return scenario;
+}
+
+// ================================
+// SEQUENTIAL REFERENCE ENGINE
+// ================================
+
+ReferenceEngine::ReferenceEngine(const DifferentialScenario& scenario)
+    : adjacency(scenario.adjacency), capacity(scenario.capacity),
+      occupancy(scenario.capacity.size(), 0), waiting(scenario.capacity.size()),
+      emergency(scenario.capacity.size()), total_vehicles(scenario.vehicles.size()) {
+    for (const auto& v : scenario.vehicles) {
+        push(v.source, Car{v.vehicle_id, v.type, v.destination, 0});
+        occupancy[v.source]++;
+    }
+}
+
+void ReferenceEngine::push(int node, const Car& car) {
+    if (car.type == VehicleType::REGULAR) {
+        waiting[node].push_back(car);
+        return;
+    }
+    auto& list = emergency[node];
+    auto before = [](const Car& a, const Car& b) {
+        if (a.type != b.type) return static_cast<int>(a.type) > static_cast<int>(b.type);
+        return a.vehicle_id < b.vehicle_id;
+    };
+    list.insert(upper_bound(list.begin(), list.end(), car, before), car);
+}
+
+ReferenceEngine::Car ReferenceEngine::pop(int node) {
+    if (!emergency[node].empty()) {
+        Car car = emergency[node].front();
+        emergency[node].erase(emergency[node].begin());
+        return car;
+    }
+    Car car = waiting[node].front();
+    waiting[node].pop_front();
+    return car;
+}
+
+int ReferenceEngine::first_hop(int from, int destination) const {
+    const auto& out = adjacency[from];
+    if (out.empty()) return -1;
+    if (find(out.begin(), out.end(), destination) != out.end()) return destination;
+
+    // BFS carrying the first hop that discovered each node
+    vector<int> via(adjacency.size(), -1);
+    queue<int> frontier;
+    via[from] = from;
+    for (int next : out) {
+        if (via[next] < 0) {
+            via[next] = next;
+            frontier.push(next);
+        }
+    }
+    while (!frontier.empty()) {
+        int curr = frontier.front();
+        frontier.pop();
+        if (curr == destination) return via[curr];
+        for (int next : adjacency[curr]) {
+            if (via[next] < 0) {
+                via[next] = via[curr];
+                frontier.push(next);
+            }
+        }
+    }
+    return out[0];
+}
+
+void ReferenceEngine::tick(vector<MovementEvent>& events) {
+    vector<int> active;
+    for (size_t i = 0; i < capacity.size(); ++i) {
+        if (queue_length(i) > 0) active.push_back(static_cast<int>(i));
+    }
+
+    for (int from : active) {
+        if (queue_length(from) == 0) continue;
+        Car car = pop(from);
+        bool is_emergency = car.type != VehicleType::REGULAR;
+
+        int to = first_hop(from, car.destination);
+        if (to < 0) {
+            events.push_back({MovementEventKind::NO_PATH, car.vehicle_id, from, -1});
+            push(from, car);
+            continue;
+        }
+
+        int allowed = capacity[to] + (is_emergency ? 1 : 0);
+        if (occupancy[to] >= allowed) {
+            events.push_back({MovementEventKind::BLOCKED, car.vehicle_id, from, to});
+            if (++car.blocked_attempts > 5) {
+                reroutes++;
+                car.blocked_attempts = 0;
+            }
+            push(from, car);
+            continue;
+        }
+
+        occupancy[from]--;
+        events.push_back({MovementEventKind::MOVE, car.vehicle_id, from, to});
+        if (to == car.destination) {
+            events.push_back({MovementEventKind::ARRIVE, car.vehicle_id, to, -1});
+            completed_count++;
+        } else {
+            occupancy[to]++;
+            push(to, car);
+        }
+    }
+}
+
+string ReferenceEngine::check_invariants() const {
+    size_t queued = 0;
+    for (size_t i = 0; i < capacity.size(); ++i) {
+        if (occupancy[i] < 0 || occupancy[i] > capacity[i] + 1) {
+            return "reference node " + to_string(i) + " occupancy " + to_string(occupancy[i]) +
+                   " outside [0, " + to_string(capacity[i] + 1) + "]";
+        }
+        if (occupancy[i] != queue_length(i)) {
+            return "reference node " + to_string(i) + " occupancy " + to_string(occupancy[i]) +
+                   " != queued " + to_string(queue_length(i));
+        }
+        queued += queue_length(i);
+    }
+    if (queued + completed_count != total_vehicles) {
+        return "reference lost vehicles: " + to_string(queued) + " queued + " + to_string(completed_count) +
+               " completed != " + to_string(total_vehicles);
+    }
+    return "";
+}
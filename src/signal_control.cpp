@@ -0,0 +1,254 @@
+#include "signal_control.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+void SignalController::build(const vector<NodeData>& nodes) {
+    const size_t n = nodes.size();
+    controller_of_node.assign(n, -1);
+    controller_node.clear();
+    phase_offset.clear();
+    phase_approach.clear();
+    movement_offset.clear();
+    movement_out.clear();
+
+    vector<vector<int>> upstream(n);
+    for (size_t i = 0; i < n; ++i) {
+        for (int adj : nodes[i].adjacent_nodes) {
+            upstream[adj].push_back(static_cast<int>(i));
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (nodes[i].type != NodeType::TRAFFIC_CONTROLLER) continue;
+
+        controller_of_node[i] = static_cast<int>(controller_node.size());
+        controller_node.push_back(static_cast<int>(i));
+        phase_offset.push_back(static_cast<int>(phase_approach.size()));
+
+        for (int approach : upstream[i]) {
+            phase_approach.push_back(approach);
+            movement_offset.push_back(static_cast<int>(movement_out.size()));
+            for (int exit : nodes[i].adjacent_nodes) {
+                if (exit != approach) movement_out.push_back(exit);
+            }
+        }
+    }
+    phase_offset.push_back(static_cast<int>(phase_approach.size()));
+    movement_offset.push_back(static_cast<int>(movement_out.size()));
+
+    queue_length.assign(n, 0.0f);
+    phase_pressure.assign(phase_approach.size(), 0.0f);
+    green_approach.assign(controller_node.size(), NO_PHASE);
+    switched.assign(controller_node.size(), 0);
+    switches = 0;
+
+    // Block -> controllers whose approaches or exits fall in it
+    const size_t blocks = (n + NodeKernels::BLOCK - 1) / NodeKernels::BLOCK;
+    vector<vector<int>> readers(blocks);
+    for (size_t c = 0; c < controller_node.size(); ++c) {
+        for (int p = phase_offset[c]; p < phase_offset[c + 1]; ++p) {
+            readers[phase_approach[p] / NodeKernels::BLOCK].push_back(static_cast<int>(c));
+            for (int m = movement_offset[p]; m < movement_offset[p + 1]; ++m) {
+                readers[movement_out[m] / NodeKernels::BLOCK].push_back(static_cast<int>(c));
+            }
+        }
+    }
+    block_offset.assign(1, 0);
+    block_controllers.clear();
+    for (auto& list : readers) {
+        sort(list.begin(), list.end());
+        list.erase(unique(list.begin(), list.end()), list.end());
+        block_controllers.insert(block_controllers.end(), list.begin(), list.end());
+        block_offset.push_back(static_cast<int>(block_controllers.size()));
+    }
+    block_dirty.assign(blocks, 0);
+    dirty_blocks.clear();
+    controller_due.assign(controller_node.size(), 0);
+    due_controllers.clear();
+    full_update = true;
+}
+
+void SignalController::update(const NodeStateArrays& state, const vector<int>& head_hop, ThreadPool& pool) {
+    if (controller_node.empty()) return;
+
+    const size_t n = queue_length.size();
+    const int32_t* waiting = state.waiting.data();
+    const int32_t* emergency = state.emergency.data();
+
+    if (full_update) {
+        for (size_t i = 0; i < n; ++i) {
+            queue_length[i] = static_cast<float>(waiting[i] + emergency[i]);
+        }
+        pool.parallel_for_range(0, controller_node.size(), [this, &head_hop](size_t lo, size_t hi) {
+            update_range(lo, hi, head_hop);
+        }, 64);
+        for (int s : switched) switches += s;
+        for (uint32_t block : dirty_blocks) block_dirty[block] = 0;
+        dirty_blocks.clear();
+        full_update = false;
+        return;
+    }
+
+    // Gather the touched blocks and the controllers that read them
+    for (uint32_t block : dirty_blocks) {
+        size_t lo = block * NodeKernels::BLOCK;
+        size_t hi = min(n, lo + NodeKernels::BLOCK);
+        for (size_t i = lo; i < hi; ++i) {
+            queue_length[i] = static_cast<float>(waiting[i] + emergency[i]);
+        }
+        for (int k = block_offset[block]; k < block_offset[block + 1]; ++k) {
+            int c = block_controllers[k];
+            if (!controller_due[c]) {
+                controller_due[c] = 1;
+                due_controllers.push_back(static_cast<uint32_t>(c));
+            }
+        }
+        block_dirty[block] = 0;
+    }
+    dirty_blocks.clear();
+    sort(due_controllers.begin(), due_controllers.end());
+
+    pool.parallel_for(0, due_controllers.size(), [this, &head_hop](size_t k) {
+        size_t c = due_controllers[k];
+        update_range(c, c + 1, head_hop);
+    }, 64);
+
+    for (uint32_t c : due_controllers) {
+        switches += switched[c];
+        controller_due[c] = 0;
+    }
+    due_controllers.clear();
+}
+
+void SignalController::update_range(size_t begin, size_t end, const vector<int>& head_hop) {
+    // Movement pressures for the whole range first: one straight pass over
+    // the contiguous movement rows of these controllers.
+    const float* q = queue_length.data();
+    for (int p = phase_offset[begin]; p < phase_offset[end]; ++p) {
+        int m_begin = movement_offset[p];
+        int m_end = movement_offset[p + 1];
+        float downstream = 0.0f;
+        for (int m = m_begin; m < m_end; ++m) {
+            downstream += q[movement_out[m]];
+        }
+        int movements = m_end - m_begin;
+        float mean_downstream = movements > 0 ? downstream / movements : 0.0f;
+        phase_pressure[p] = q[phase_approach[p]] - mean_downstream;
+    }
+
+    for (size_t c = begin; c < end; ++c) {
+        int node = controller_node[c];
+        int best = NO_PHASE;
+        float best_pressure = 0.0f;
+        for (int p = phase_offset[c]; p < phase_offset[c + 1]; ++p) {
+            int approach = phase_approach[p];
+            if (head_hop[approach] != node) continue;   // no vehicle waiting to enter
+            // Ties keep the current phase so equal pressure does not flap
+            bool better = best == NO_PHASE || phase_pressure[p] > best_pressure ||
+                          (phase_pressure[p] == best_pressure && approach == green_approach[c]);
+            if (better) {
+                best = approach;
+                best_pressure = phase_pressure[p];
+            }
+        }
+
+        switched[c] = 0;
+        if (best != NO_PHASE && best != green_approach[c]) {
+            switched[c] = green_approach[c] != NO_PHASE ? 1 : 0;
+            green_approach[c] = best;
+        }
+    }
+}
+
+SignalPlan SignalController::default_plan(int green_ticks) const {
+    SignalPlan plan;
+    plan.green_ticks.assign(phase_approach.size(), max(1, green_ticks));
+    plan.offset.assign(controller_node.size(), 0);
+    return plan;
+}
+
+int SignalController::cycle_length(const SignalPlan& plan, size_t controller) const {
+    int cycle = 0;
+    for (int p = phase_offset[controller]; p < phase_offset[controller + 1]; ++p) {
+        cycle += plan.green_ticks[p];
+    }
+    return cycle;
+}
+
+int SignalController::plan_green_at(const SignalPlan& plan, size_t controller, size_t tick) const {
+    int cycle = cycle_length(plan, controller);
+    if (cycle <= 0) return NO_PHASE;
+
+    int t = static_cast<int>((tick + plan.offset[controller]) % cycle);
+    for (int p = phase_offset[controller]; p < phase_offset[controller + 1]; ++p) {
+        t -= plan.green_ticks[p];
+        if (t < 0) return phase_approach[p];
+    }
+    return NO_PHASE;
+}
+
+void SignalController::apply_plan(const SignalPlan& plan, size_t tick) {
+    for (size_t c = 0; c < controller_node.size(); ++c) {
+        int green = plan_green_at(plan, c, tick);
+        if (green != green_approach[c] && green_approach[c] != NO_PHASE) switches++;
+        green_approach[c] = green;
+    }
+}
+
+// Plan file, one line per controller, nodes as letters:
+//   C: offset 1; A=3 B=2 F=1
+bool SignalController::save_plan(const string& path, const SignalPlan& plan) const {
+    ofstream file(path);
+    if (!file.is_open()) return false;
+
+    file << "# Signal Plan" << endl;
+    file << "# <controller>: offset <ticks>; <approach>=<green ticks> ..." << endl;
+    for (size_t c = 0; c < controller_node.size(); ++c) {
+        file << static_cast<char>('A' + controller_node[c]) << ": offset " << plan.offset[c] << ";";
+        for (int p = phase_offset[c]; p < phase_offset[c + 1]; ++p) {
+            file << " " << static_cast<char>('A' + phase_approach[p]) << "=" << plan.green_ticks[p];
+        }
+        file << endl;
+    }
+    return true;
+}
+
+bool SignalController::load_plan(const string& path, SignalPlan& plan) const {
+    ifstream file(path);
+    if (!file.is_open()) return false;
+
+    plan = default_plan(1);
+    string line;
+    while (getline(file, line)) {
+        if (line.empty() || line[0] == '#' || line.find(':') == string::npos) continue;
+
+        int node = line[0] - 'A';
+        if (node < 0 || node >= static_cast<int>(controller_of_node.size())) continue;
+        int c = controller_of_node[node];
+        if (c < 0) continue;
+
+        size_t semicolon = line.find(';');
+        string head = line.substr(line.find(':') + 1, semicolon - line.find(':') - 1);
+        stringstream head_ss(head);
+        string word;
+        int offset = 0;
+        if (head_ss >> word >> offset && word == "offset") plan.offset[c] = max(0, offset);
+
+        if (semicolon == string::npos) continue;
+        stringstream ss(line.substr(semicolon + 1));
+        string entry;
+        while (ss >> entry) {
+            size_t eq = entry.find('=');
+            if (eq == string::npos) continue;
+            int approach = entry[0] - 'A';
+            int ticks = stoi(entry.substr(eq + 1));
+            for (int p = phase_offset[c]; p < phase_offset[c + 1]; ++p) {
+                if (phase_approach[p] == approach) plan.green_ticks[p] = max(1, ticks);
+            }
+        }
+    }
+    return true;
+}
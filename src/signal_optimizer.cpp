@@ -0,0 +1,82 @@
+#include "signal_optimizer.h"
+#include <algorithm>
+
+using namespace std;
+
+SignalOptimizer::SignalOptimizer(const NetworkSnapshot& network, ThreadPool& thread_pool)
+    : net(network), pool(thread_pool) {}
+
+void SignalOptimizer::build_moves(const SignalPlan& plan, int max_green_ticks) {
+    const SignalController& signals = *net.signals;
+    moves.clear();
+    cycle_length.assign(signals.controller_count(), 0);
+
+    for (size_t c = 0; c < signals.controller_count(); ++c) {
+        cycle_length[c] = signals.cycle_length(plan, c);
+        for (int p = signals.phase_begin(c); p < signals.phase_end(c); ++p) {
+            if (plan.green_ticks[p] < max_green_ticks) moves.push_back({false, p, +1});
+            if (plan.green_ticks[p] > 1) moves.push_back({false, p, -1});
+        }
+        // Offsets only matter with more than one phase to rotate through
+        if (signals.phase_end(c) - signals.phase_begin(c) > 1) {
+            moves.push_back({true, static_cast<int>(c), +1});
+            moves.push_back({true, static_cast<int>(c), -1});
+        }
+    }
+}
+
+void SignalOptimizer::apply_move(SignalPlan& plan, const Move& move, const vector<int>& cycle) {
+    if (move.is_offset) {
+        int length = max(1, cycle[move.index]);
+        plan.offset[move.index] = (plan.offset[move.index] + move.delta + length) % length;
+    } else {
+        plan.green_ticks[move.index] += move.delta;
+    }
+}
+
+void SignalOptimizer::score_moves(const SignalPlan& plan, size_t horizon_ticks) {
+    move_cost.assign(moves.size(), 0.0);
+    pool.parallel_for_range(0, moves.size(), [this, &plan, horizon_ticks](size_t lo, size_t hi) {
+        FastForwardSimulator sim(net);
+        SignalPlan local = plan;
+        for (size_t m = lo; m < hi; ++m) {
+            const Move& move = moves[m];
+            apply_move(local, move, cycle_length);
+            move_cost[m] = sim.evaluate(&local, horizon_ticks);
+            apply_move(local, Move{move.is_offset, move.index, -move.delta}, cycle_length);
+        }
+    });
+}
+
+SignalOptimizerResult SignalOptimizer::optimize(const SignalPlan& start, size_t horizon_ticks,
+                                                size_t max_rounds, int max_green_ticks) {
+    SignalOptimizerResult result;
+    result.plan = start;
+
+    FastForwardSimulator reference(net);
+    result.uncontrolled_cost = reference.evaluate(nullptr, horizon_ticks);
+    result.initial_cost = reference.evaluate(&start, horizon_ticks);
+    result.cost = result.initial_cost;
+    result.evaluations = 2;
+
+    for (size_t round = 0; round < max_rounds; ++round) {
+        build_moves(result.plan, max_green_ticks);
+        if (moves.empty()) break;
+
+        score_moves(result.plan, horizon_ticks);
+        result.evaluations += moves.size();
+        result.rounds++;
+
+        // Lowest cost wins; ties go to the earliest move so runs are reproducible
+        size_t best = 0;
+        for (size_t m = 1; m < moves.size(); ++m) {
+            if (move_cost[m] < move_cost[best]) best = m;
+        }
+        if (move_cost[best] >= result.cost) break;   // local optimum
+
+        apply_move(result.plan, moves[best], cycle_length);
+        result.cost = move_cost[best];
+    }
+
+    return result;
+}
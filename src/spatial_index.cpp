@@ -0,0 +1,179 @@
+#include "spatial_index.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+using namespace std;
+
+static constexpr double EARTH_RADIUS_KM = 6371.0088;
+static constexpr double KM_PER_DEGREE = EARTH_RADIUS_KM * M_PI / 180.0;
+
+void SpatialIndex::build(const vector<GeoPoint>& points, bool is_geo) {
+    geographic = is_geo;
+    point_count = points.size();
+    position = points;
+    cell_start.assign(2, 0);
+    cell_points.clear();
+    cell_coords.clear();
+    grid_w = grid_h = 1;
+    if (points.empty()) return;
+
+    double max_x = points[0].x, max_y = points[0].y;
+    min_x = points[0].x;
+    min_y = points[0].y;
+    for (const auto& p : points) {
+        min_x = min(min_x, p.x);
+        max_x = max(max_x, p.x);
+        min_y = min(min_y, p.y);
+        max_y = max(max_y, p.y);
+    }
+
+    // Geographic grids are in degrees; the smallest cos(lat) across the box
+    // keeps the longitude scale a lower bound everywhere in it, with slack
+    // for great circles cutting inside the parallel.
+    if (geographic) {
+        double widest_lat = max(fabs(min_y), fabs(max_y));
+        x_scale = 0.9 * KM_PER_DEGREE * cos(min(widest_lat, 89.0) * M_PI / 180.0);
+        y_scale = KM_PER_DEGREE;
+    } else {
+        x_scale = y_scale = 1.0;
+    }
+
+    double span_x = max(max_x - min_x, 1e-9);
+    double span_y = max(max_y - min_y, 1e-9);
+    double cells_wanted = max(1.0, points.size() / 2.0);
+    cell_size = max(sqrt(span_x * span_y / cells_wanted), max(span_x, span_y) / 4096.0);
+    grid_w = min(4096, static_cast<int>(span_x / cell_size) + 1);
+    grid_h = min(4096, static_cast<int>(span_y / cell_size) + 1);
+
+    // Counting sort of point ids by cell
+    vector<uint32_t> cell_of(points.size());
+    cell_start.assign(static_cast<size_t>(grid_w) * grid_h + 1, 0);
+    for (size_t i = 0; i < points.size(); ++i) {
+        cell_of[i] = cell_y(points[i].y) * grid_w + cell_x(points[i].x);
+        cell_start[cell_of[i] + 1]++;
+    }
+    for (size_t c = 1; c < cell_start.size(); ++c) {
+        cell_start[c] += cell_start[c - 1];
+    }
+    cell_points.resize(points.size());
+    cell_coords.resize(points.size());
+    vector<uint32_t> fill_pos(cell_start.begin(), cell_start.end() - 1);
+    for (size_t i = 0; i < points.size(); ++i) {
+        uint32_t slot = fill_pos[cell_of[i]]++;
+        cell_points[slot] = static_cast<int>(i);
+        cell_coords[slot] = points[i];
+    }
+}
+
+int SpatialIndex::cell_x(double x) const {
+    return max(0, min(grid_w - 1, static_cast<int>((x - min_x) / cell_size)));
+}
+
+int SpatialIndex::cell_y(double y) const {
+    return max(0, min(grid_h - 1, static_cast<int>((y - min_y) / cell_size)));
+}
+
+double SpatialIndex::ring_bound(int rings) const {
+    return rings <= 0 ? 0.0 : (rings - 1) * cell_size * min(x_scale, y_scale);
+}
+
+double SpatialIndex::distance(const GeoPoint& a, const GeoPoint& b) const {
+    if (!geographic) {
+        double dx = a.x - b.x;
+        double dy = a.y - b.y;
+        return sqrt(dx * dx + dy * dy);
+    }
+    double lat1 = a.y * M_PI / 180.0;
+    double lat2 = b.y * M_PI / 180.0;
+    double dlat = lat2 - lat1;
+    double dlon = (b.x - a.x) * M_PI / 180.0;
+    double h = sin(dlat / 2) * sin(dlat / 2) + cos(lat1) * cos(lat2) * sin(dlon / 2) * sin(dlon / 2);
+    return 2.0 * EARTH_RADIUS_KM * asin(min(1.0, sqrt(h)));
+}
+
+int SpatialIndex::nearest(const GeoPoint& p) const {
+    if (point_count == 0) return -1;
+
+    int cx = cell_x(p.x);
+    int cy = cell_y(p.y);
+    int best = -1;
+    double best_dist = numeric_limits<double>::infinity();
+    int max_ring = max(grid_w, grid_h);
+
+    // Scan square rings of cells outward until nothing farther out can win
+    for (int r = 0; r <= max_ring; ++r) {
+        if (best >= 0 && ring_bound(r) > best_dist) break;
+        for (int gy = cy - r; gy <= cy + r; ++gy) {
+            if (gy < 0 || gy >= grid_h) continue;
+            bool edge_row = gy == cy - r || gy == cy + r;
+            for (int gx = cx - r; gx <= cx + r; gx += (edge_row || r == 0) ? 1 : 2 * r) {
+                if (gx < 0 || gx >= grid_w) continue;
+                size_t cell = static_cast<size_t>(gy) * grid_w + gx;
+                for (uint32_t s = cell_start[cell]; s < cell_start[cell + 1]; ++s) {
+                    double d = distance(p, cell_coords[s]);
+                    if (d < best_dist) {
+                        best_dist = d;
+                        best = cell_points[s];
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+
+void SpatialIndex::within(const GeoPoint& p, double radius, vector<int>& out) const {
+    if (point_count == 0) return;
+
+    int rx = static_cast<int>(ceil(radius / (cell_size * x_scale)));
+    int ry = static_cast<int>(ceil(radius / (cell_size * y_scale)));
+    int cx = cell_x(p.x);
+    int cy = cell_y(p.y);
+    for (int gy = max(0, cy - ry); gy <= min(grid_h - 1, cy + ry); ++gy) {
+        for (int gx = max(0, cx - rx); gx <= min(grid_w - 1, cx + rx); ++gx) {
+            size_t cell = static_cast<size_t>(gy) * grid_w + gx;
+            for (uint32_t s = cell_start[cell]; s < cell_start[cell + 1]; ++s) {
+                if (distance(p, cell_coords[s]) <= radius) out.push_back(cell_points[s]);
+            }
+        }
+    }
+}
+
+void SpatialIndex::k_nearest(const GeoPoint& p, size_t k, vector<int>& out) const {
+    out.clear();
+    if (point_count == 0 || k == 0) return;
+    k = min(k, point_count);
+
+    int cx = cell_x(p.x);
+    int cy = cell_y(p.y);
+    int max_ring = max(grid_w, grid_h);
+    vector<pair<double, int>> found;   // (distance, point), max-heap of size k
+
+    for (int r = 0; r <= max_ring; ++r) {
+        if (found.size() == k && ring_bound(r) > found.front().first) break;
+        for (int gy = cy - r; gy <= cy + r; ++gy) {
+            if (gy < 0 || gy >= grid_h) continue;
+            bool edge_row = gy == cy - r || gy == cy + r;
+            for (int gx = cx - r; gx <= cx + r; gx += (edge_row || r == 0) ? 1 : 2 * r) {
+                if (gx < 0 || gx >= grid_w) continue;
+                size_t cell = static_cast<size_t>(gy) * grid_w + gx;
+                for (uint32_t s = cell_start[cell]; s < cell_start[cell + 1]; ++s) {
+                    double d = distance(p, cell_coords[s]);
+                    if (found.size() < k) {
+                        found.emplace_back(d, cell_points[s]);
+                        push_heap(found.begin(), found.end());
+                    } else if (d < found.front().first) {
+                        pop_heap(found.begin(), found.end());
+                        found.back() = {d, cell_points[s]};
+                        push_heap(found.begin(), found.end());
+                    }
+                }
+            }
+        }
+    }
+
+    sort_heap(found.begin(), found.end());
+    for (const auto& entry : found) out.push_back(entry.second);
+}
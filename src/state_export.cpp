@@ -0,0 +1,212 @@
+#include "state_export.h"
+#include <cstring>
+#include <new>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define STATE_EXPORT_SHM 1
+#endif
+
+using namespace std;
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static size_t frame_size(size_t nodes, size_t edges) {
+    return align_up(sizeof(SharedFrameHeader) + nodes * 2 * sizeof(int32_t) + edges * sizeof(float), 64);
+}
+
+// ================================
+// WRITER
+// ================================
+
+bool SharedStateExporter::open(const string& name, size_t node_count, const vector<pair<int, int>>& edges) {
+    close();
+#ifdef STATE_EXPORT_SHM
+    size_t edges_offset = align_up(sizeof(SharedStateHeader), 64);
+    size_t first_frame = align_up(edges_offset + edges.size() * 2 * sizeof(int32_t), 64);
+    size_t bytes_per_frame = frame_size(node_count, edges.size());
+    size_t total = first_frame + 2 * bytes_per_frame;
+
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) return false;
+    if (ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void* mapping = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    base = static_cast<char*>(mapping);
+    mapped_bytes = total;
+    shm_name = name;
+
+    SharedStateHeader* header = new (base) SharedStateHeader;
+    header->node_count = static_cast<uint32_t>(node_count);
+    header->edge_count = static_cast<uint32_t>(edges.size());
+    header->edges_offset = edges_offset;
+    header->frame_offset[0] = first_frame;
+    header->frame_offset[1] = first_frame + bytes_per_frame;
+    header->frame_bytes = bytes_per_frame;
+    header->front.store(0, memory_order_relaxed);
+    header->frame_sequence[0].store(0, memory_order_relaxed);
+    header->frame_sequence[1].store(0, memory_order_relaxed);
+
+    int32_t* edge_table = reinterpret_cast<int32_t*>(base + edges_offset);
+    for (size_t e = 0; e < edges.size(); ++e) {
+        edge_table[2 * e] = edges[e].first;
+        edge_table[2 * e + 1] = edges[e].second;
+    }
+
+    // Magic last: a reader that sees it sees a complete header
+    header->version = SharedStateLayout::VERSION;
+    atomic_thread_fence(memory_order_release);
+    header->magic = SharedStateLayout::MAGIC;
+    return true;
+#else
+    (void)name;
+    (void)node_count;
+    (void)edges;
+    return false;
+#endif
+}
+
+void SharedStateExporter::close() {
+#ifdef STATE_EXPORT_SHM
+    if (base) {
+        munmap(base, mapped_bytes);
+        shm_unlink(shm_name.c_str());
+    }
+#endif
+    base = nullptr;
+    mapped_bytes = 0;
+}
+
+SharedFrame SharedStateExporter::frame_at(uint32_t index) const {
+    const SharedStateHeader* header = reinterpret_cast<const SharedStateHeader*>(base);
+    char* frame = base + header->frame_offset[index];
+    size_t n = header->node_count;
+    SharedFrame view;
+    view.occupancy = reinterpret_cast<int32_t*>(frame + sizeof(SharedFrameHeader));
+    view.queue_depth = view.occupancy + n;
+    view.edge_flow = reinterpret_cast<float*>(view.queue_depth + n);
+    return view;
+}
+
+SharedFrame SharedStateExporter::begin_frame(uint64_t tick, double simulated_seconds) {
+    SharedStateHeader* header = reinterpret_cast<SharedStateHeader*>(base);
+    writing = 1 - header->front.load(memory_order_relaxed);
+
+    // Odd sequence: readers that raced onto this frame will retry
+    header->frame_sequence[writing].fetch_add(1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    SharedFrameHeader* frame = reinterpret_cast<SharedFrameHeader*>(base + header->frame_offset[writing]);
+    frame->tick = tick;
+    frame->simulated_seconds = simulated_seconds;
+    return frame_at(writing);
+}
+
+void SharedStateExporter::end_frame() {
+    SharedStateHeader* header = reinterpret_cast<SharedStateHeader*>(base);
+    header->frame_sequence[writing].fetch_add(1, memory_order_release);
+    header->front.store(writing, memory_order_release);
+}
+
+// ================================
+// READER
+// ================================
+
+bool SharedStateReader::open(const string& name) {
+    close();
+#ifdef STATE_EXPORT_SHM
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SharedStateHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    base = static_cast<const char*>(mapping);
+    mapped_bytes = info.st_size;
+    const SharedStateHeader* header = reinterpret_cast<const SharedStateHeader*>(base);
+    if (header->magic != SharedStateLayout::MAGIC || header->version != SharedStateLayout::VERSION) {
+        close();
+        return false;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    return true;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+void SharedStateReader::close() {
+#ifdef STATE_EXPORT_SHM
+    if (base) munmap(const_cast<char*>(base), mapped_bytes);
+#endif
+    base = nullptr;
+    mapped_bytes = 0;
+}
+
+size_t SharedStateReader::node_count() const {
+    return base ? reinterpret_cast<const SharedStateHeader*>(base)->node_count : 0;
+}
+
+size_t SharedStateReader::edge_count() const {
+    return base ? reinterpret_cast<const SharedStateHeader*>(base)->edge_count : 0;
+}
+
+pair<int, int> SharedStateReader::edge(size_t e) const {
+    const SharedStateHeader* header = reinterpret_cast<const SharedStateHeader*>(base);
+    const int32_t* table = reinterpret_cast<const int32_t*>(base + header->edges_offset);
+    return {table[2 * e], table[2 * e + 1]};
+}
+
+bool SharedStateReader::read_latest(SharedFrameHeader& frame_header, vector<int32_t>& occupancy,
+                                    vector<int32_t>& queue_depth, vector<float>& edge_flow) const {
+    if (!base) return false;
+    const SharedStateHeader* header = reinterpret_cast<const SharedStateHeader*>(base);
+    size_t n = header->node_count;
+    size_t e = header->edge_count;
+    occupancy.resize(n);
+    queue_depth.resize(n);
+    edge_flow.resize(e);
+
+    // A writer that died mid-frame leaves its sequence odd forever; give up
+    // after a bounded number of yields so the caller's idle logic can run
+    for (int attempt = 0; attempt < READ_ATTEMPTS; ++attempt) {
+        if (attempt > 0) this_thread::yield();
+        uint32_t index = header->front.load(memory_order_acquire);
+        uint64_t before = header->frame_sequence[index].load(memory_order_acquire);
+        if (before == 0) return false;      // never written
+        if (before & 1) continue;           // writer lapped us onto this frame
+
+        const char* frame = base + header->frame_offset[index];
+        const int32_t* occ = reinterpret_cast<const int32_t*>(frame + sizeof(SharedFrameHeader));
+        memcpy(&frame_header, frame, sizeof(SharedFrameHeader));
+        memcpy(occupancy.data(), occ, n * sizeof(int32_t));
+        memcpy(queue_depth.data(), occ + n, n * sizeof(int32_t));
+        memcpy(edge_flow.data(), occ + 2 * n, e * sizeof(float));
+
+        atomic_thread_fence(memory_order_acquire);
+        if (header->frame_sequence[index].load(memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
@@ -0,0 +1,85 @@
+#include "steady_state.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+// ================================
+// STEADY-STATE DETECTION
+// ================================
+
+// Two-sided 95% Student t quantiles for 1..30 degrees of freedom
+static double student_t_975(size_t dof) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (dof == 0) return table[0];
+    return dof <= 30 ? table[dof - 1] : 1.960;
+}
+
+SteadyStateDetector::SteadyStateDetector(double precision, size_t batch_count)
+    : precision(precision), batch_count(max<size_t>(batch_count, 2)) {}
+
+SteadyStateResult SteadyStateDetector::evaluate() const {
+    SteadyStateResult result;
+    size_t groups = observations.size() / MSER_GROUP;
+    if (groups < batch_count) return result;
+
+    vector<double> group_mean(groups);
+    for (size_t g = 0; g < groups; ++g) {
+        double sum = 0.0;
+        for (size_t k = 0; k < MSER_GROUP; ++k) sum += observations[g * MSER_GROUP + k];
+        group_mean[g] = sum / MSER_GROUP;
+    }
+
+    // MSER(d) = sum_{j>=d} (x_j - mean_d)^2 / (n - d)^2 from suffix sums
+    size_t search = groups / 2;
+    double suffix_sum = 0.0, suffix_sq = 0.0;
+    for (size_t g = search; g < groups; ++g) {
+        suffix_sum += group_mean[g];
+        suffix_sq += group_mean[g] * group_mean[g];
+    }
+    size_t best = search;
+    double best_score = numeric_limits<double>::infinity();
+    for (size_t d = search + 1; d-- > 0;) {
+        if (d < search) {
+            suffix_sum += group_mean[d];
+            suffix_sq += group_mean[d] * group_mean[d];
+        }
+        double m = static_cast<double>(groups - d);
+        double score = max(0.0, suffix_sq - suffix_sum * suffix_sum / m) / (m * m);
+        if (score <= best_score) {
+            best_score = score;
+            best = d;
+        }
+    }
+    result.warmup = best * MSER_GROUP;
+    if (best >= search) return result;
+
+    // Batch means over what is left; leftover observations come off the front
+    size_t remaining = observations.size() - result.warmup;
+    size_t batch_size = remaining / batch_count;
+    if (batch_size == 0) return result;
+    size_t start = observations.size() - batch_size * batch_count;
+
+    vector<double> batch_mean(batch_count, 0.0);
+    for (size_t b = 0; b < batch_count; ++b) {
+        for (size_t k = 0; k < batch_size; ++k) batch_mean[b] += observations[start + b * batch_size + k];
+        batch_mean[b] /= batch_size;
+    }
+    double mean = 0.0;
+    for (double x : batch_mean) mean += x;
+    mean /= batch_count;
+    double var = 0.0;
+    for (double x : batch_mean) var += (x - mean) * (x - mean);
+    var /= batch_count - 1;
+
+    result.batches = batch_count;
+    result.mean = mean;
+    result.half_width = student_t_975(batch_count - 1) * sqrt(var / batch_count);
+    result.steady = result.half_width <= precision * fabs(mean);
+    return result;
+}
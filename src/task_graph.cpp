@@ -0,0 +1,95 @@
+#include "task_graph.h"
+#include <stdexcept>
+
+using namespace std;
+
+TaskGraph::TaskId TaskGraph::add_task(function<void()> work) {
+    auto task = make_unique<Task>();
+    task->work = move(work);
+    tasks->push_back(move(task));
+    return tasks->size() - 1;
+}
+
+void TaskGraph::precede(TaskId before, TaskId after) {
+    if (before >= tasks->size() || after >= tasks->size()) {
+        throw out_of_range("TaskGraph::precede on unknown task");
+    }
+    (*tasks)[before]->successors.push_back(after);
+    (*tasks)[after]->predecessor_count++;
+}
+
+TaskGraph::TaskId TaskGraph::then(TaskId before, function<void()> work) {
+    TaskId id = add_task(move(work));
+    precede(before, id);
+    return id;
+}
+
+void TaskGraph::run(ThreadPool& pool) {
+    if (current_run && current_run->remaining.load() > 0) {
+        throw runtime_error("TaskGraph::run while a previous run is in flight");
+    }
+
+    auto state = make_shared<RunState>();
+    state->tasks = tasks;
+    state->pool = &pool;
+    state->remaining = tasks->size();
+    current_run = state;
+
+    for (auto& task : *tasks) {
+        task->pending = task->predecessor_count;
+    }
+    for (TaskId id = 0; id < tasks->size(); ++id) {
+        if ((*tasks)[id]->predecessor_count == 0) {
+            pool.enqueue([state, id]() { execute(state, id); });
+        }
+    }
+}
+
+void TaskGraph::execute(const shared_ptr<RunState>& state, TaskId id) {
+    Task& task = *(*state->tasks)[id];
+    try {
+        if (task.work) task.work();
+    } catch (...) {
+        lock_guard<mutex> lock(state->done_mutex);
+        if (!state->error) state->error = current_exception();
+    }
+
+    for (TaskId next : task.successors) {
+        Task& successor = *(*state->tasks)[next];
+        if (successor.pending.fetch_sub(1) == 1) {
+            state->pool->enqueue([state, next]() { execute(state, next); });
+        }
+    }
+
+    state->finished++;
+    if (state->remaining.fetch_sub(1) == 1) {
+        lock_guard<mutex> lock(state->done_mutex);
+        state->done_cv.notify_all();
+    }
+}
+
+void TaskGraph::wait() {
+    if (!current_run) return;
+    auto state = current_run;
+    unique_lock<mutex> lock(state->done_mutex);
+    state->done_cv.wait(lock, [&state] { return state->remaining.load() == 0; });
+    if (state->error) rethrow_exception(state->error);
+}
+
+bool TaskGraph::wait_until(chrono::steady_clock::time_point deadline) {
+    if (!current_run) return true;
+    auto state = current_run;
+    unique_lock<mutex> lock(state->done_mutex);
+    bool done = state->done_cv.wait_until(lock, deadline,
+                                          [&state] { return state->remaining.load() == 0; });
+    if (done && state->error) rethrow_exception(state->error);
+    return done;
+}
+
+bool TaskGraph::wait_for(chrono::steady_clock::duration timeout) {
+    return wait_until(chrono::steady_clock::now() + timeout);
+}
+
+size_t TaskGraph::completed() const {
+    return current_run ? current_run->finished.load() : 0;
+}
@@ -1,20 +1,47 @@
 #include "thread_pool.h"
 #include "display.h"
+#include "cpu_topology.h"
 #include <iostream>
 
 using namespace std;
 
-ThreadPool::ThreadPool(size_t threads) {
+ThreadPool::ThreadPool(size_t threads, bool pin_workers) {
+    if (pin_workers) {
+        vector<int> cpus = CpuTopology::allowed_cpus();
+        for (size_t i = 0; i < threads; ++i) {
+            worker_cpus.push_back(cpus[i % cpus.size()]);
+        }
+    }
+
+    worker_tasks.resize(threads);
+    worker_waiting.assign(threads, 0);
+
     for(size_t i = 0; i < threads; ++i) {
-        workers.emplace_back([this] {
+        workers.emplace_back([this, i] {
+            if (!this->worker_cpus.empty() && !CpuTopology::pin_current_thread(this->worker_cpus[i])) {
+                cout << Display::WARNING_ICON << " Could not pin worker " << i
+                     << " to CPU " << this->worker_cpus[i] << endl;
+            }
             for(;;) {
                 function<void()> task;
                 {
                     unique_lock<mutex> lock(this->queue_mutex);
-                    this->condition.wait(lock, [this]{ return this->stop || !this->tasks.empty(); });
-                    if(this->stop && this->tasks.empty()) return;
-                    task = move(this->tasks.front());
-                    this->tasks.pop();
+                    auto& own = this->worker_tasks[i];
+                    this->idle_workers++;
+                    this->worker_waiting[i] = 1;
+                    this->condition.wait(lock, [this, &own]{
+                        return this->stop || !this->tasks.empty() || !own.empty();
+                    });
+                    this->worker_waiting[i] = 0;
+                    this->idle_workers--;
+                    if (!own.empty()) {
+                        task = move(own.front());
+                        own.pop();
+                    } else {
+                        if(this->stop && this->tasks.empty()) return;
+                        task = move(this->tasks.front());
+                        this->tasks.pop();
+                    }
                 }
                 try {
                     task();
@@ -26,6 +53,21 @@ ThreadPool::ThreadPool(size_t threads) {
     }
 }
 
+pair<size_t, size_t> ThreadPool::static_range(size_t part, size_t begin, size_t end, size_t align) const {
+    size_t parts = max<size_t>(1, workers.size());
+    align = max<size_t>(1, align);
+    size_t units = (end - begin + align - 1) / align;
+    size_t per_part = (units + parts - 1) / parts;
+    size_t lo = begin + min(units, part * per_part) * align;
+    size_t hi = begin + min(units, (part + 1) * per_part) * align;
+    return {min(lo, end), min(hi, end)};
+}
+
+int ThreadPool::worker_numa_node(size_t worker) const {
+    if (worker >= worker_cpus.size()) return -1;
+    return CpuTopology::numa_node_of_cpu(worker_cpus[worker]);
+}
+
 ThreadPool::~ThreadPool() {
     {
         unique_lock<mutex> lock(queue_mutex);
@@ -35,4 +77,4 @@ ThreadPool::~ThreadPool() {
     for(thread &worker: workers) {
         worker.join();
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,112 @@
+#include "traffic_env.h"
+#include <algorithm>
+
+using namespace std;
+
+// ================================
+// TRAFFIC ENV
+// ================================
+
+TrafficEnv::TrafficEnv(const NetworkSnapshot& network, size_t max_ticks_per_episode, double rate)
+    : net(network), sim(network),
+      controllers(network.signals ? network.signals->controller_count() : 0),
+      max_ticks(max_ticks_per_episode), arrival_rate(rate),
+      active_phase(controllers, -1) {}
+
+int TrafficEnv::phase_count(size_t controller) const {
+    return net.signals->phase_end(controller) - net.signals->phase_begin(controller);
+}
+
+int TrafficEnv::approach_of(size_t controller, int phase) const {
+    if (phase < 0 || phase >= phase_count(controller)) return SignalController::NO_PHASE;
+    return net.signals->phase_approach_at(net.signals->phase_begin(controller) + phase);
+}
+
+void TrafficEnv::reset(uint64_t seed, float* observation) {
+    episode_seed = seed;
+    sim.reset();
+    fill(active_phase.begin(), active_phase.end(), -1);
+    if (observation) observe(observation);
+}
+
+void TrafficEnv::spawn_arrivals() {
+    if (arrival_rate <= 0.0 || net.destinations.empty()) return;
+
+    PhiloxEngine rng(episode_seed, 0, RandomPurpose::ENV_ARRIVALS, static_cast<uint32_t>(sim.tick()));
+    poisson_distribution<int> arrivals(arrival_rate);
+    uniform_int_distribution<int> node_dist(0, static_cast<int>(net.node_count) - 1);
+    uniform_int_distribution<int> dest_dist(0, static_cast<int>(net.destinations.size()) - 1);
+    for (int a = arrivals(rng); a > 0; --a) {
+        sim.add_vehicle(node_dist(rng), net.destinations[dest_dist(rng)], VehicleType::REGULAR);
+    }
+}
+
+EnvStep TrafficEnv::step(const int* actions, float* observation) {
+    for (size_t c = 0; c < controllers; ++c) {
+        int approach = approach_of(c, actions[c]);
+        active_phase[c] = approach == SignalController::NO_PHASE ? -1 : actions[c];
+        sim.set_green(c, approach);
+    }
+
+    spawn_arrivals();
+    sim.step();
+
+    EnvStep result;
+    result.reward = -static_cast<float>(sim.in_network());
+    result.done = sim.tick() >= max_ticks || (sim.in_network() == 0 && arrival_rate <= 0.0);
+    if (observation) observe(observation);
+    return result;
+}
+
+void TrafficEnv::observe(float* observation) const {
+    const size_t n = net.node_count;
+    for (size_t i = 0; i < n; ++i) {
+        observation[i] = static_cast<float>(sim.queue_length(i));
+    }
+    for (size_t i = 0; i < n; ++i) {
+        int capacity = net.capacity[i];
+        observation[n + i] = capacity > 0 ? static_cast<float>(sim.occupancy_at(i)) / capacity : 0.0f;
+    }
+    for (size_t c = 0; c < controllers; ++c) {
+        observation[2 * n + c] = static_cast<float>(active_phase[c]);
+    }
+}
+
+// ================================
+// VECTOR TRAFFIC ENV
+// ================================
+
+VectorTrafficEnv::VectorTrafficEnv(const NetworkSnapshot& network, size_t num_envs, ThreadPool& thread_pool,
+                                   size_t max_ticks, double arrival_rate)
+    : next_seed(num_envs, 0), pool(thread_pool) {
+    envs.reserve(num_envs);
+    for (size_t i = 0; i < num_envs; ++i) {
+        envs.emplace_back(network, max_ticks, arrival_rate);
+    }
+}
+
+void VectorTrafficEnv::reset(uint64_t seed, float* observations) {
+    const size_t obs_size = observation_size();
+    pool.parallel_for(0, envs.size(), [&](size_t i) {
+        next_seed[i] = seed + i;
+        envs[i].reset(next_seed[i], observations + i * obs_size);
+    }, 8);
+}
+
+void VectorTrafficEnv::step(const int* actions, float* observations, float* rewards, uint8_t* dones) {
+    const size_t obs_size = observation_size();
+    const size_t act_size = action_size();
+    const size_t n = envs.size();
+
+    // Seeds advance by N so every episode of every environment is distinct
+    pool.parallel_for(0, n, [&](size_t i) {
+        float* obs = observations + i * obs_size;
+        EnvStep result = envs[i].step(actions + i * act_size, obs);
+        rewards[i] = result.reward;
+        dones[i] = result.done ? 1 : 0;
+        if (result.done) {
+            next_seed[i] += n;
+            envs[i].reset(next_seed[i], obs);
+        }
+    }, 8);
+}
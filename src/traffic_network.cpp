@@ -1,11 +1,18 @@
 #include "traffic_network.h"
 #include "display.h"
+#include "movement_observers.h"
+#include "signal_optimizer.h"
+#include "traffic_env.h"
+#include "map_matching.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
-#include <random>
 #include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <limits>
+#include <random>
 #include <thread>
 #include <unordered_set>
 
@@ -18,6 +25,14 @@ using namespace chrono;
 
 TrafficNetwork::TrafficNetwork() : thread_pool(make_unique<ThreadPool>(4)) {
     config.load_defaults();
+
+    // Wake every blocking wait that is not a StopToken wait itself
+    stop_token = stop_source.get_token();
+    stop_token.on_stop([this]() {
+        { lock_guard<mutex> lock(global_coordinator_mutex); }
+        cv_token_allocation.notify_all();
+        node_agents.stop();
+    });
 }
 
 TrafficNetwork::~TrafficNetwork() {
@@ -49,6 +64,32 @@ bool TrafficNetwork::initialize(const string& input_file) {
             return false;
         }
 
+        configure_workers();
+        build_class_limits();
+        build_delay_models();
+        stats.windows.configure(config.metrics_bucket, static_cast<size_t>(config.metrics_history));
+        admission.configure(static_cast<size_t>(config.entry_buffer));
+        if (!admission.empty()) {
+            cout << Display::INFO_ICON << " Admission control on " << admission.entry_count()
+                 << " entry points, demand " << config.demand_rate << " vehicles/tick each" << endl;
+        }
+        if (!config.gps_trace_file.empty()) load_gps_trips();
+        build_congestion_tracker();
+        node_state_dirty.clear();
+        fairness.set_alarm_seconds(config.max_block_time);
+        signals.build(nodes);
+        head_hops.clear();
+        open_state_export();
+        if (config.signal_policy == SignalPolicy::FIXED_PLAN &&
+            config.mode != SimulationMode::SIGNAL_OPTIMIZER) {
+            if (signals.load_plan(config.signal_plan_file, signal_plan)) {
+                cout << Display::INFO_ICON << " Signal plan loaded from " << config.signal_plan_file << endl;
+            } else {
+                cout << Display::WARNING_ICON << " Cannot read signal plan " << config.signal_plan_file
+                     << " - signals disabled" << endl;
+                config.signal_policy = SignalPolicy::NONE;
+            }
+        }
         display_network_summary();
         cout << Display::SUCCESS_ICON << " Traffic network initialized successfully!" << endl;
 
@@ -76,9 +117,20 @@ void TrafficNetwork::run_simulation() {
     }
 
     simulation_running = true;
+    stats.start_time = steady_clock::now();    // not counting the mode prompt or loading
 
     if (config.mode == SimulationMode::STEP_BY_STEP) {
         run_step_by_step_simulation();
+    } else if (config.mode == SimulationMode::MESOSCOPIC) {
+        run_flow_simulation();
+    } else if (config.mode == SimulationMode::HYBRID) {
+        run_hybrid_simulation();
+    } else if (config.mode == SimulationMode::SIGNAL_OPTIMIZER) {
+        run_signal_optimizer();
+    } else if (config.mode == SimulationMode::ENV_BENCHMARK) {
+        run_env_benchmark();
+    } else if (config.mode == SimulationMode::DIFFERENTIAL_CHECK) {
+        run_differential_check();
     } else {
         run_automatic_simulation();
     }
@@ -93,7 +145,12 @@ void TrafficNetwork::select_simulation_mode() {
     cout << "1. Step-by-Step (see each vehicle movement)" << endl;
     cout << "2. Automatic (real-time dashboard)" << endl;
     cout << "3. Fast Run (final results only)" << endl;
-    cout << "Enter choice (1-3): ";
+    cout << "4. Mesoscopic Flow (aggregate flows, city-scale networks)" << endl;
+    cout << "5. Hybrid (vehicles in the focus region, flows elsewhere)" << endl;
+    cout << "6. Signal Plan Optimizer (offline search, writes a plan file)" << endl;
+    cout << "7. Control Environment Benchmark (vectorized random rollouts)" << endl;
+    cout << "8. Differential Check (token engine vs sequential reference)" << endl;
+    cout << "Enter choice (1-8): ";
     
     string choice;
     getline(cin, choice);
@@ -102,6 +159,16 @@ void TrafficNetwork::select_simulation_mode() {
         config.mode = SimulationMode::AUTOMATIC;
     } else if (choice == "3") {
         config.mode = SimulationMode::FAST_RUN;
+    } else if (choice == "4") {
+        config.mode = SimulationMode::MESOSCOPIC;
+    } else if (choice == "5") {
+        config.mode = SimulationMode::HYBRID;
+    } else if (choice == "6") {
+        config.mode = SimulationMode::SIGNAL_OPTIMIZER;
+    } else if (choice == "7") {
+        config.mode = SimulationMode::ENV_BENCHMARK;
+    } else if (choice == "8") {
+        config.mode = SimulationMode::DIFFERENTIAL_CHECK;
     } else {
         config.mode = SimulationMode::STEP_BY_STEP;  // Default
     }
@@ -117,6 +184,21 @@ void TrafficNetwork::select_simulation_mode() {
         case SimulationMode::FAST_RUN:
             cout << "Fast Run" << endl;
             break;
+        case SimulationMode::MESOSCOPIC:
+            cout << "Mesoscopic Flow" << endl;
+            break;
+        case SimulationMode::HYBRID:
+            cout << "Hybrid Micro/Meso" << endl;
+            break;
+        case SimulationMode::SIGNAL_OPTIMIZER:
+            cout << "Signal Plan Optimizer" << endl;
+            break;
+        case SimulationMode::ENV_BENCHMARK:
+            cout << "Control Environment Benchmark" << endl;
+            break;
+        case SimulationMode::DIFFERENTIAL_CHECK:
+            cout << "Differential Check" << endl;
+            break;
     }
 }
 
@@ -127,7 +209,7 @@ void TrafficNetwork::run_step_by_step_simulation() {
     
     int max_steps = 50; // Prevent infinite loops
     
-    for (int step = 1; step <= max_steps && !shutdown_requested; ++step) {
+    for (int step = 1; step <= max_steps && !stop_token.stop_requested(); ++step) {
         stats.step_count = step;
         
         cout << "\n";
@@ -137,6 +219,7 @@ void TrafficNetwork::run_step_by_step_simulation() {
         Display::print_step_separator();
         
         bool movement_occurred = execute_single_step();
+        publish_state(step * config.token_cycle_duration);
         
         if (!movement_occurred) {
             cout << Display::INFO_ICON << " No more vehicle movements possible." << endl;
@@ -148,7 +231,7 @@ void TrafficNetwork::run_step_by_step_simulation() {
         if (!config.auto_advance_steps) {
             Display::wait_for_enter();
         } else {
-            this_thread::sleep_for(chrono::milliseconds(1000));
+            stop_token.wait_for(chrono::milliseconds(1000));
         }
     }
     
@@ -158,10 +241,23 @@ void TrafficNetwork::run_step_by_step_simulation() {
 bool TrafficNetwork::execute_single_step() {
     bool movement_occurred = false;
     
-    // Process each node for potential vehicle movements
-    for (size_t i = 0; i < nodes.size() && !movement_occurred; ++i) {
-        if (nodes[i].get_queue_size() > 0) {
+    // A fixed plan may hold every waiting vehicle at red for a while; let the
+    // plan run through one full cycle before concluding nothing can move
+    int attempts = 1;
+    if (config.signal_policy == SignalPolicy::FIXED_PLAN) {
+        for (size_t c = 0; c < signals.controller_count(); ++c) {
+            attempts = max(attempts, signals.cycle_length(signal_plan, c));
+        }
+    }
+
+    for (int attempt = 0; attempt < attempts && !movement_occurred; ++attempt) {
+        // Only nodes with queued vehicles can produce a movement
+        vector<uint32_t> active = active_nodes.snapshot();
+        plan_next_hops(active);
+        update_signals(active);
+        for (uint32_t i : active) {
             movement_occurred = process_single_vehicle_movement(i);
+            if (movement_occurred) break;
         }
     }
     
@@ -171,154 +267,560 @@ bool TrafficNetwork::execute_single_step() {
 bool TrafficNetwork::process_single_vehicle_movement(size_t node_idx) {
     if (node_idx >= nodes.size()) return false;
 
-    NodeData& node = nodes[node_idx];
     bool is_emergency = false;
 
     // Try to get a vehicle from this node
-    if (node.has_emergency_vehicles()) {
-        Vehicle vehicle = node.emergency_queue.top();
-        node.emergency_queue.pop();
-        is_emergency = true;
-
-        return process_vehicle_step_by_step(vehicle, node_idx, is_emergency);
-    } else if (!node.waiting_queue.empty()) {
-        Vehicle vehicle = node.waiting_queue.front();
-        node.waiting_queue.pop();
-        is_emergency = false;
-
-        return process_vehicle_step_by_step(vehicle, node_idx, is_emergency);
+    Vehicle vehicle(0, VehicleType::REGULAR, 0, 0);
+    if (dequeue_vehicle(node_idx, vehicle, is_emergency)) {
+        NarratingMovementObserver narrator;
+        return process_vehicle(vehicle, node_idx, is_emergency, narrator);
     }
 
     return false;
 }
 
-bool TrafficNetwork::process_vehicle_step_by_step(Vehicle& vehicle, size_t from_node, bool is_emergency) {
-    NodeData& node = nodes[from_node];
+void TrafficNetwork::run_flow_simulation() {
+    Display::print_header("MESOSCOPIC FLOW SIMULATION");
 
-    // Display vehicle selection
-    cout << Display::INFO_ICON << " Processing vehicle " 
-         << Display::get_vehicle_color(vehicle.to_string()) << vehicle.to_string() 
-         << Display::RESET << " at Node " << Display::BOLD << node.node_char << Display::RESET;
-    cout << " (Destination: " << Display::BOLD << static_cast<char>('A' + vehicle.destination_node) 
-         << Display::RESET << ")" << endl;
-
-    // Find next hop
-    int next_node = find_best_next_hop(from_node, vehicle.destination_node);
-    
-    if (next_node == -1) {
-        cout << Display::WARNING_ICON << " No path available - returning to queue" << endl;
-        return_vehicle_to_queue(vehicle, from_node, is_emergency);
-        return false;
+    FlowModel model;
+    model.build(nodes);
+    model.set_service_rate(1.0 / config.token_cycle_duration);
+    vector<bool> no_vehicle_nodes(nodes.size(), false);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        absorb_into_flow(model, i);
     }
+    sync_flow_occupancy(model, no_vehicle_nodes);
+    double initial_stock = model.total_stock();
+
+    cout << Display::INFO_ICON << " Commodity flows over " << nodes.size() << " nodes and "
+         << model.edge_count() << " edges, sweep length " << config.flow_time_step << "s" << endl;
+
+    // Sweeps run back-to-back: simulated time is decoupled from wall time,
+    // and rates in the report are per simulated second
+    auto wall_start = steady_clock::now();
+    uint64_t recorded_moves = 0;
+    while (model.kpis().simulated_time < config.simulation_time && !stop_token.stop_requested()) {
+        double sweep_start = model.kpis().simulated_time;
+        model.step(config.flow_time_step);
+        record_flow_moves(model, sweep_start, recorded_moves);
+        if (state_export.is_open()) {
+            sync_flow_occupancy(model, no_vehicle_nodes);
+            publish_state(model.kpis().simulated_time, &model);
+        }
+        if (model.total_stock() < 1e-6) {
+            break;  // Network drained
+        }
+    }
+    double wall_ms = duration<double, milli>(steady_clock::now() - wall_start).count();
+    sync_flow_occupancy(model, no_vehicle_nodes);   // final report shows end-of-run occupancy
 
-    // Check if movement is possible
-    if (can_move_to_node_safe(next_node, vehicle.type)) {
-        perform_vehicle_move_with_display(vehicle, from_node, next_node);
-        return true;
-    } else {
-        cout << Display::WARNING_ICON << " Destination Node " 
-             << static_cast<char>('A' + next_node) << " is at capacity - blocking" << endl;
-        return_vehicle_to_queue(vehicle, from_node, is_emergency);
-        vehicle.blocked_attempts++;
-        return false;
+    {
+        lock_guard<mutex> stats_lock(stats_mutex);
+        stats.simulated_seconds = model.kpis().simulated_time;
+        model.export_stats(stats);
     }
+
+    const FlowKpis& kpis = model.kpis();
+    double remaining = model.total_stock();
+    double completed = kpis.completed_regular + kpis.completed_emergency;
+
+    Display::print_section_header("Flow Model Results");
+    cout << fixed << setprecision(2);
+    cout << "Simulated Time:   " << kpis.simulated_time << " s in " << kpis.sweeps << " sweeps" << endl;
+    cout << "Wall Time:        " << wall_ms << " ms" << endl;
+    cout << "Vehicles Moved:   " << kpis.vehicles_moved << endl;
+    cout << "Completed:        " << completed << " (regular " << kpis.completed_regular
+         << ", emergency " << kpis.completed_emergency << ")" << endl;
+    cout << "Still In Network: " << remaining << endl;
+    cout << "Conservation Err: " << scientific << setprecision(2)
+         << (initial_stock - completed - remaining) << fixed << endl;
+
+    display_final_report();
 }
 
-void TrafficNetwork::perform_vehicle_move_with_display(Vehicle& vehicle, size_t from_node, int to_node) {
-    char from_char = static_cast<char>('A' + from_node);
-    char to_char = static_cast<char>('A' + to_node);
-    
-    // Remove from source
-    if (nodes[from_node].current_vehicles > 0) {
-        nodes[from_node].current_vehicles--;
+void TrafficNetwork::run_hybrid_simulation() {
+    Display::print_header("HYBRID MICRO/MESO SIMULATION");
+
+    vector<bool> micro(nodes.size(), false);
+    size_t micro_count = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        micro[i] = i < focus_region.size() && focus_region[i];
+        if (micro[i]) micro_count++;
+    }
+    if (micro_count == 0) {
+        cout << Display::WARNING_ICON << " No # Focus Region in input; simulating every node as vehicles" << endl;
+        micro.assign(nodes.size(), true);
+        micro_count = nodes.size();
     }
 
-    vehicle.current_node = to_node;
+    FlowModel model;
+    model.build(nodes);
+    model.set_service_rate(1.0 / config.token_cycle_duration);
+    model.set_external_nodes(micro);
 
-    // Display the movement
-    cout << Display::MOVE_ICON << " " << Display::BOLD 
-         << Display::get_vehicle_color(vehicle.to_string()) << vehicle.to_string() 
-         << Display::RESET << " moves from Node " << Display::BOLD << from_char 
-         << Display::RESET << " to Node " << Display::BOLD << to_char << Display::RESET;
+    // Vehicles outside the focus region start as flow stock
+    int initial_vehicles = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        initial_vehicles += nodes[i].get_queue_size();
+        if (!micro[i]) absorb_into_flow(model, i);
+    }
+    sync_flow_occupancy(model, micro);
+
+    cout << Display::INFO_ICON << " " << micro_count << " focus nodes as vehicles, "
+         << nodes.size() - micro_count << " nodes as flows" << endl;
+
+    // Lockstep ticks of one token cycle: a flow sweep, boundary conversion,
+    // then the token tick over the focus nodes.
+    const double dt = config.token_cycle_duration;
+    double simulated_time = 0.0;
+    int flow_to_vehicles = 0;
+    int vehicles_to_flow = 0;
+    SilentMovementObserver silent;
+
+    auto wall_start = steady_clock::now();
+    uint64_t recorded_moves = 0;
+    while (simulated_time < config.simulation_time && !stop_token.stop_requested()) {
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (micro[i]) model.set_external_load(i, nodes[i].current_vehicles);
+        }
+        model.step(dt);
+        record_flow_moves(model, simulated_time, recorded_moves);
+
+        model.take_boundary_vehicles([&](int node, int destination, VehicleType type, int count) {
+            for (int c = 0; c < count; ++c) {
+                Vehicle vehicle = make_vehicle(next_vehicle_id++, type, node, destination);
+                nodes[node].current_vehicles++;
+                enqueue_vehicle(node, vehicle, vehicle_class(type).emergency);
+            }
+            flow_to_vehicles += count;
+        });
+        sync_flow_occupancy(model, micro);
 
-    // Update stats
+        run_tick(silent, &micro);
+
+        // Vehicles that left the focus region rejoin the flow
+        for (uint32_t i : active_nodes.snapshot()) {
+            if (!micro[i]) vehicles_to_flow += absorb_into_flow(model, i);
+        }
+        sync_flow_occupancy(model, micro);
+
+        simulated_time += dt;
+        publish_state(simulated_time, &model);
+        if (active_nodes.empty() && arrivals.empty() && model.total_stock() < 1e-6) {
+            break;  // Network drained
+        }
+    }
+    double wall_ms = duration<double, milli>(steady_clock::now() - wall_start).count();
+
+    int vehicles_remaining = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        vehicles_remaining += in_transit[i];
+        if (micro[i]) vehicles_remaining += nodes[i].get_queue_size();
+    }
+
+    double completed;
     {
         lock_guard<mutex> stats_lock(stats_mutex);
-        stats.total_moves++;
+        completed = stats.successful_routes + model.kpis().completed_regular
+                    + model.kpis().completed_emergency;
+        stats.simulated_seconds = simulated_time;
+        model.export_stats(stats);
     }
+    double remaining = vehicles_remaining + model.total_stock();
+
+    Display::print_section_header("Hybrid Results");
+    cout << fixed << setprecision(2);
+    cout << "Simulated Time:   " << simulated_time << " s" << endl;
+    cout << "Wall Time:        " << wall_ms << " ms" << endl;
+    cout << "Flow -> Vehicles: " << flow_to_vehicles << endl;
+    cout << "Vehicles -> Flow: " << vehicles_to_flow << endl;
+    cout << "Completed:        " << completed << endl;
+    cout << "Still In Network: " << remaining << " (" << vehicles_remaining << " vehicles, "
+         << model.total_stock() << " flow)" << endl;
+    cout << "Conservation Err: " << scientific << setprecision(2)
+         << (initial_vehicles - completed - remaining) << fixed << endl;
 
-    if (to_node == vehicle.destination_node) {
-        cout << " " << Display::SUCCESS_ICON << Display::GREEN << " DESTINATION REACHED!" 
-             << Display::RESET << endl;
-        
-        // Vehicle reached destination
-        {
-            lock_guard<mutex> stats_lock(stats_mutex);
-            if (vehicle.type == VehicleType::REGULAR) {
-                stats.total_vehicles_processed++;
-            } else {
-                stats.emergency_vehicles_processed++;
-            }
-            stats.successful_routes++;
+    display_final_report();
+}
+
+// Moves the flow model made in the sweep starting at t go into the window
+// metrics, which also sets the stats clock to simulated time
+void TrafficNetwork::record_flow_moves(const FlowModel& model, double t, uint64_t& recorded) {
+    uint64_t moved = static_cast<uint64_t>(llround(model.kpis().vehicles_moved));
+    lock_guard<mutex> stats_lock(stats_mutex);
+    stats.simulated_seconds = t;
+    stats.windows.record_moves(t, moved - recorded);
+    recorded = moved;
+}
+
+int TrafficNetwork::absorb_into_flow(FlowModel& model, size_t node_idx) {
+    int absorbed = 0;
+    Vehicle vehicle(0, VehicleType::REGULAR, 0, 0);
+    bool is_emergency = false;
+    while (dequeue_vehicle(node_idx, vehicle, is_emergency)) {
+        fairness.drop(node_idx, vehicle_class_index(vehicle.type), vehicle.queue_stamp);
+        model.add_stock(static_cast<int>(node_idx), vehicle.destination_node, vehicle.type, 1.0);
+        absorbed++;
+    }
+    return absorbed;
+}
+
+void TrafficNetwork::sync_flow_occupancy(const FlowModel& model, const vector<bool>& micro) {
+    // Flow nodes report rounded-up stock so the vehicle engine's capacity
+    // checks never admit more than the flow model has room for
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (!micro[i]) {
+            nodes[i].current_vehicles = static_cast<int>(ceil(model.node_occupancy(i) - 1e-9)) + in_transit[i];
+            touch_node(i);
         }
+    }
+}
+
+void TrafficNetwork::run_signal_optimizer() {
+    Display::print_header("SIGNAL PLAN OPTIMIZER");
+
+    if (signals.controller_count() == 0) {
+        cout << Display::WARNING_ICON << " No traffic controller nodes - nothing to optimize" << endl;
         return;
-    } else {
-        cout << endl;
     }
 
-    // Add to destination node
-    nodes[to_node].current_vehicles++;
-    if (vehicle.type == VehicleType::REGULAR) {
-        nodes[to_node].waiting_queue.push(vehicle);
+    NetworkSnapshot snapshot;
+    export_snapshot(snapshot);
+    SignalOptimizer optimizer(snapshot, *thread_pool);
+
+    cout << Display::INFO_ICON << " " << signals.controller_count() << " controllers, "
+         << signals.phase_count() << " phases, " << snapshot.vehicles.size() << " vehicles, "
+         << config.optimizer_horizon << " ticks per evaluation" << endl;
+
+    auto wall_start = steady_clock::now();
+    SignalOptimizerResult result = optimizer.optimize(signals.default_plan(2), config.optimizer_horizon,
+                                                      config.optimizer_rounds, config.max_green_ticks);
+    double wall_ms = duration<double, milli>(steady_clock::now() - wall_start).count();
+
+    Display::print_section_header("Optimizer Results");
+    cout << fixed << setprecision(1);
+    cout << "Evaluations:      " << result.evaluations << " in " << result.rounds << " rounds" << endl;
+    cout << "Wall Time:        " << wall_ms << " ms ("
+         << setprecision(3) << wall_ms / max<size_t>(1, result.evaluations) << " ms per evaluation)" << endl;
+    cout << setprecision(1);
+    cout << "Uncontrolled:     " << result.uncontrolled_cost << " vehicle-ticks" << endl;
+    cout << "Initial Plan:     " << result.initial_cost << " vehicle-ticks" << endl;
+    cout << "Optimized Plan:   " << result.cost << " vehicle-ticks" << endl;
+
+    if (signals.save_plan(config.signal_plan_file, result.plan)) {
+        cout << Display::SUCCESS_ICON << " Plan written to " << config.signal_plan_file
+             << " (run with SIGNAL_CONTROL: FIXED_PLAN to use it)" << endl;
     } else {
-        nodes[to_node].emergency_queue.push(vehicle);
+        cout << Display::ERROR_ICON << " Cannot write " << config.signal_plan_file << endl;
+    }
+}
+
+void TrafficNetwork::run_env_benchmark() {
+    Display::print_header("CONTROL ENVIRONMENT BENCHMARK");
+
+    NetworkSnapshot snapshot;
+    export_snapshot(snapshot);
+    VectorTrafficEnv envs(snapshot, config.env_count, *thread_pool,
+                          config.env_episode_ticks, config.env_arrival_rate);
+
+    const size_t count = envs.size();
+    const size_t obs_size = envs.observation_size();
+    const size_t act_size = envs.action_size();
+    vector<float> observations(count * obs_size);
+    vector<float> rewards(count);
+    vector<uint8_t> dones(count);
+    vector<int> actions(count * act_size);
+
+    cout << Display::INFO_ICON << " " << count << " environments, observation size " << obs_size
+         << ", " << act_size << " actions, " << config.env_steps << " vector steps" << endl;
+
+    envs.reset(config.random_seed, observations.data());
+    CounterRng action_rng(config.random_seed);
+
+    double reward_sum = 0.0;
+    size_t episodes = 0;
+    double step_us = 0.0;
+    for (int s = 0; s < config.env_steps && !stop_token.stop_requested(); ++s) {
+        // Random policy: any phase of each controller, or all open
+        for (size_t e = 0; e < count; ++e) {
+            for (size_t c = 0; c < act_size; ++c) {
+                uint32_t choices = static_cast<uint32_t>(envs.env(e).phase_count(c)) + 1;
+                actions[e * act_size + c] = static_cast<int>(action_rng.below(
+                    choices, static_cast<uint32_t>(e), static_cast<uint32_t>(s),
+                    RandomPurpose::ENV_ACTIONS, static_cast<uint32_t>(c))) - 1;
+            }
+        }
+
+        auto step_start = steady_clock::now();
+        envs.step(actions.data(), observations.data(), rewards.data(), dones.data());
+        step_us += duration<double, micro>(steady_clock::now() - step_start).count();
+
+        for (size_t e = 0; e < count; ++e) {
+            reward_sum += rewards[e];
+            episodes += dones[e];
+        }
     }
 
-    cout << Display::INFO_ICON << " Vehicle " << vehicle.to_string() 
-         << " added to Node " << to_char << " queue" << endl;
+    double env_steps = static_cast<double>(config.env_steps) * count;
+    Display::print_section_header("Environment Results");
+    cout << fixed << setprecision(2);
+    cout << "Vector Step:      " << step_us / config.env_steps << " us" << endl;
+    cout << "Per Env Step:     " << step_us / env_steps << " us" << endl;
+    cout << "Throughput:       " << setprecision(0) << env_steps / (step_us / 1e6) << " env-steps/s" << endl;
+    cout << "Episodes Done:    " << episodes << endl;
+    cout << "Mean Reward:      " << setprecision(3) << reward_sum / env_steps << endl;
+}
+
+bool TrafficNetwork::run_differential_check() {
+    Display::print_header("DIFFERENTIAL CHECK");
+    cout << Display::INFO_ICON << " " << config.diff_scenarios << " random scenarios, up to "
+         << config.diff_max_ticks << " ticks each, seed " << config.diff_seed << endl;
+
+    // One scenario engine for the whole run, reloaded per scenario; signals
+    // stay off and it works on this network's pool while the check runs
+    TrafficNetwork engine;
+    engine.config = config;
+    engine.config.signal_policy = SignalPolicy::NONE;
+    engine.config.state_export_name.clear();
+    swap(engine.thread_pool, thread_pool);
+
+    size_t ticks = 0, events_compared = 0, failures = 0;
+    for (int k = 0; k < config.diff_scenarios && !stop_token.stop_requested(); ++k) {
+        DifferentialScenario scenario = DifferentialScenario::random(config.diff_seed + k);
+        engine.load_scenario(scenario);
+        ReferenceEngine reference(scenario);
+
+        string failure;
+        vector<MovementEvent> actual, expected;
+        for (int t = 0; t < config.diff_max_ticks && failure.empty(); ++t) {
+            actual.clear();
+            expected.clear();
+            engine.run_recorded_tick(actual);
+            reference.tick(expected);
+            ticks++;
+
+            size_t common = min(actual.size(), expected.size());
+            size_t d = 0;
+            while (d < common && actual[d] == expected[d]) d++;
+            events_compared += d;
+            if (d < actual.size() || d < expected.size()) {
+                auto describe = [](const vector<MovementEvent>& list, size_t i) {
+                    static const char* kind_names[] = {"MOVE", "ARRIVE", "BLOCKED", "BOUNCED", "RED", "NO_PATH"};
+                    if (i >= list.size()) return string("<none>");
+                    const MovementEvent& e = list[i];
+                    return string(kind_names[static_cast<int>(e.kind)]) + " vehicle " + to_string(e.vehicle_id) +
+                           " " + to_string(e.from_node) + "->" + to_string(e.to_node);
+                };
+                failure = "tick " + to_string(t) + " event " + to_string(d) + ": engine " +
+                          describe(actual, d) + ", reference " + describe(expected, d);
+                break;
+            }
+
+            failure = engine.check_engine_invariants(scenario.vehicles.size());
+            if (failure.empty()) failure = reference.check_invariants();
+            for (size_t i = 0; i < reference.node_count() && failure.empty(); ++i) {
+                if (engine.nodes[i].current_vehicles != reference.occupancy_at(i) ||
+                    engine.nodes[i].get_queue_size() != reference.queue_length(i)) {
+                    failure = "tick " + to_string(t) + " node " + to_string(i) + " state differs";
+                }
+            }
+            if (reference.in_network() == 0) break;
+        }
+        if (failure.empty() && static_cast<size_t>(engine.stats.rerouting_attempts) != reference.rerouting_attempts()) {
+            failure = "rerouting attempts " + to_string(engine.stats.rerouting_attempts) +
+                      " vs " + to_string(reference.rerouting_attempts());
+        }
+
+        if (!failure.empty()) {
+            failures++;
+            if (failures <= 10) {
+                cout << Display::ERROR_ICON << " Seed " << scenario.seed << " (" << scenario.capacity.size()
+                     << " nodes, " << scenario.vehicles.size() << " vehicles): " << failure << endl;
+            }
+        }
+    }
+
+    Display::print_section_header("Differential Results");
+    cout << "Scenarios:        " << config.diff_scenarios << endl;
+    cout << "Ticks Compared:   " << ticks << endl;
+    cout << "Events Matched:   " << events_compared << endl;
+    cout << "Failures:         " << failures << endl;
+    swap(engine.thread_pool, thread_pool);
+    if (failures == 0) {
+        cout << Display::SUCCESS_ICON << " Token engine matches the reference engine" << endl;
+    }
+    return failures == 0;
+}
+
+void TrafficNetwork::load_scenario(const DifferentialScenario& scenario) {
+    const size_t n = scenario.capacity.size();
+    adjacency_matrix.assign(n, vector<int>(n, 0));
+    nodes.clear();
+    for (size_t i = 0; i < n; ++i) {
+        nodes.emplace_back(static_cast<int>(i), static_cast<char>('A' + i), NodeType::WAIT_NODE,
+                           scenario.capacity[i]);
+        nodes[i].adjacent_nodes = scenario.adjacency[i];
+        for (int j : scenario.adjacency[i]) adjacency_matrix[i][j] = 1;
+    }
+    active_nodes.reset(n);
+    focus_region.assign(n, false);
+    planned_hops.clear();
+    fairness.reset(n, VEHICLE_CLASS_COUNT);
+    stats = SystemStats();
+    admission.clear();
+
+    // The reference engine moves without travel time and serves one vehicle
+    // per node per tick
+    delay_models.assign(2, DelayModel{});
+    DelayModel::parse("FIXED 0", delay_models[0]);
+    build_edge_offsets();
+    edge_travel_model.assign(edge_offset[n], 0);
+    stochastic_travel = false;
+    node_service_model.assign(n, NO_DELAY_MODEL);
+    token_tick = 0;
+    reset_arrivals();
+
+    class_reserved.clear();
+    class_priority.clear();
+    build_class_limits();
+
+    // Emergency queues order by arrival time; pin it to the id so ties
+    // cannot depend on the clock
+    for (const auto& v : scenario.vehicles) {
+        Vehicle vehicle = make_vehicle(v.vehicle_id, v.type, v.source, v.destination);
+        vehicle.arrival_time = steady_clock::time_point(nanoseconds(v.vehicle_id));
+        enqueue_vehicle(v.source, vehicle, vehicle_class(v.type).emergency);
+        nodes[v.source].current_vehicles++;
+    }
+    next_vehicle_id = static_cast<int>(scenario.vehicles.size()) + 1;
+    build_congestion_tracker();
+    node_state_dirty.clear();
+    signals.build(nodes);
+    head_hops.clear();
+}
+
+// The token loop's tick without the lock or the cycle sleep
+void TrafficNetwork::run_recorded_tick(vector<MovementEvent>& events) {
+    RecordingMovementObserver recorder{events};
+    run_tick(recorder);
+}
+
+string TrafficNetwork::check_engine_invariants(size_t total_vehicles) const {
+    size_t queued = 0;
+    for (const auto& node : nodes) {
+        string name = string(1, node.node_char);
+        if (node.current_vehicles < 0 || node.current_vehicles > node.capacity + 1) {
+            return "node " + name + " holds " + to_string(node.current_vehicles) +
+                   " vehicles, capacity " + to_string(node.capacity) + " + 1";
+        }
+        int travelling = in_transit[node.node_id];
+        if (node.current_vehicles != node.get_queue_size() + travelling) {
+            return "node " + name + " counts " + to_string(node.current_vehicles) +
+                   " vehicles but queues " + to_string(node.get_queue_size()) +
+                   " with " + to_string(travelling) + " in transit";
+        }
+        if (node.get_queue_size() > 0 && !active_nodes.contains(node.node_id)) {
+            return "node " + name + " has vehicles but is not in the active set";
+        }
+        queued += node.get_queue_size() + travelling;
+    }
+    if (queued + stats.successful_routes != total_vehicles) {
+        return "engine lost vehicles: " + to_string(queued) + " queued + " +
+               to_string(stats.successful_routes) + " completed != " + to_string(total_vehicles);
+    }
+    return "";
 }
 
 void TrafficNetwork::run_automatic_simulation() {
     // Start simulation threads
-    vector<future<void>> futures;
-    futures.push_back(thread_pool->enqueue([this]() { token_allocation_loop(); }));
+    TaskGraph simulation_tasks;
+    simulation_tasks.add_task([this]() { token_allocation_loop(); });
 
-    for (size_t i = 0; i < nodes.size(); ++i) {
-        futures.push_back(thread_pool->enqueue([this, i]() {
-            traffic_processing_loop(i);
-        }));
-    }
+    start_node_agents();
+    simulation_tasks.add_task([this]() { node_agents.run(); });
 
     if (config.mode == SimulationMode::AUTOMATIC) {
-        futures.push_back(thread_pool->enqueue([this]() { ui_update_loop(); }));
+        simulation_tasks.add_task([this]() { ui_update_loop(); });
     }
+    simulation_tasks.run(*thread_pool);
 
-    this_thread::sleep_for(chrono::milliseconds(200));
+    stop_token.wait_for(chrono::milliseconds(200));
     display_simulation_start();
 
-    auto start_time = steady_clock::now();
-    while (!shutdown_requested) {
-        auto elapsed = duration_cast<seconds>(steady_clock::now() - start_time).count();
-        if (elapsed >= config.simulation_time) {
-            break;
-        }
-        this_thread::sleep_for(chrono::milliseconds(100));
-    }
+    // Returns early if anything requests a stop during the run
+    wait_for_run_end();
 
-    shutdown_requested = true;
-    cv_token_allocation.notify_all();
+    stop_source.request_stop();
     display_shutdown_message();
 
-    for (auto& future : futures) {
-        if (future.wait_for(chrono::seconds(2)) == future_status::timeout) {
-            cout << Display::WARNING_ICON << " Thread shutdown timeout" << endl;
-        }
+    // One deadline for the whole join rather than a timeout per loop
+    auto deadline = steady_clock::now() +
+        duration_cast<steady_clock::duration>(chrono::duration<double>(config.shutdown_timeout));
+    if (!simulation_tasks.wait_until(deadline)) {
+        cout << Display::WARNING_ICON << " Thread shutdown timeout" << endl;
     }
 
     simulation_running = false;
     display_final_report();
 }
 
+// Sleeps until SIMULATION_TIME, a stop request, or an early stop. Every
+// token cycle it checks for a drained network and, with STEADY_STATE,
+// feeds that cycle's throughput to the steady-state detector.
+void TrafficNetwork::wait_for_run_end() {
+    auto run_end = steady_clock::now() +
+        duration_cast<steady_clock::duration>(chrono::duration<double>(config.simulation_time));
+    auto interval = duration_cast<steady_clock::duration>(
+        chrono::duration<double>(max(config.token_cycle_duration, 0.05)));
+    SteadyStateDetector detector(config.steady_precision, static_cast<size_t>(config.steady_batches));
+
+    int last_moves = 0;
+    double last_time = 0.0;
+    {
+        lock_guard<mutex> stats_lock(stats_mutex);
+        last_moves = stats.total_moves;
+        last_time = stats.elapsed_seconds();
+    }
+
+    while (!stop_token.stop_requested() && steady_clock::now() < run_end) {
+        stop_token.wait_for(min(interval, run_end - steady_clock::now()));
+        if (config.early_stop == EarlyStop::NONE || stop_token.stop_requested()) continue;
+
+        if (network_drained()) {
+            early_stop_reason = "network drained";
+            return;
+        }
+        if (config.early_stop != EarlyStop::STEADY_STATE) continue;
+
+        int moves;
+        double now;
+        {
+            lock_guard<mutex> stats_lock(stats_mutex);
+            moves = stats.total_moves;
+            now = stats.elapsed_seconds();
+        }
+        if (now <= last_time) continue;
+        detector.add((moves - last_moves) / (now - last_time));
+        last_moves = moves;
+        last_time = now;
+
+        SteadyStateResult steady = detector.evaluate();
+        if (steady.steady) {
+            stringstream reason;
+            reason << fixed << setprecision(2) << "steady state, throughput " << steady.mean << " +/- "
+                   << steady.half_width << " moves/s after " << steady.warmup << " warm-up cycles";
+            early_stop_reason = reason.str();
+            return;
+        }
+    }
+}
+
+bool TrafficNetwork::network_drained() {
+    lock_guard<mutex> lock(global_coordinator_mutex);
+    if (!active_nodes.empty() || !arrivals.empty() || admission.buffered() > 0) return false;
+    return admission.empty() || config.demand_rate <= 0.0;
+}
+
 // ================================
 // DISPLAY METHODS (abbreviated for space)
 // ================================
@@ -337,13 +839,22 @@ void TrafficNetwork::display_current_state() {
 }
 
 void TrafficNetwork::display_node_status_table() {
+    // Large networks list only the hottest nodes
+    if (nodes.size() > static_cast<size_t>(config.top_k_nodes)) {
+        display_congested_nodes(static_cast<size_t>(config.top_k_nodes));
+        return;
+    }
+    refresh_node_state();
+
     cout << "+------+-------+----------+----------+----------+-----------+" << endl;
     cout << "| Node | Type  | Capacity |   Usage  | Waiting  |  Emergency|" << endl;
     cout << "+------+-------+----------+----------+----------+-----------+" << endl;
 
-    for (const auto& node : nodes) {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const NodeData& node = nodes[i];
         string type_short = (node.type == NodeType::TRAFFIC_CONTROLLER) ? "CTRL" : "WAIT";
-        string status_color = Display::get_status_color(node.get_status());
+        string status_color = Display::get_status_color(
+            NodeKernels::status_name(static_cast<NodeStatus>(node_state.status[i])));
 
         cout << "| " << Display::BOLD << node.node_char << Display::RESET
              << "    | " << setw(5) << type_short
@@ -358,6 +869,77 @@ void TrafficNetwork::display_node_status_table() {
     cout << "+------+-------+----------+----------+----------+-----------+" << endl;
 }
 
+void TrafficNetwork::display_congested_nodes(size_t k) {
+    congestion.top(k, hottest_nodes);
+
+    cout << "Most congested " << hottest_nodes.size() << " of " << nodes.size() << " nodes" << endl;
+    cout << "+------+------+----------+----------+-----------+---------+" << endl;
+    cout << "| Rank | Node |   Usage  | Waiting  | Emergency | Blocked |" << endl;
+    cout << "+------+------+----------+----------+-----------+---------+" << endl;
+    for (size_t r = 0; r < hottest_nodes.size(); ++r) {
+        const NodeData& node = nodes[hottest_nodes[r]];
+        const CongestionKey& key = congestion.key(hottest_nodes[r]);
+        string status_color = Display::get_status_color(node.get_status());
+        cout << "| " << setw(4) << r + 1
+             << " | " << Display::BOLD << setw(4) << node.node_char << Display::RESET
+             << " | " << status_color << setw(5) << node.current_vehicles << "/" << setw(2) << node.capacity
+             << Display::RESET
+             << " | " << setw(8) << node.waiting_queue.size()
+             << " | " << Display::RED << setw(9) << node.emergency_queue.size() << Display::RESET
+             << " | " << setw(7) << key.blocked << " |" << endl;
+    }
+    cout << "+------+------+----------+----------+-----------+---------+" << endl;
+}
+
+void TrafficNetwork::display_fairness_report() {
+    // Waits count from when a vehicle joined a node's queue; a vehicle still
+    // queued contributes its current age to Max Wait
+    cout << "+------------+---------+---------+---------+-----------+----------+-------+--------+" << endl;
+    cout << "| Class      | Offered |  Served |  Blocks | Mean Wait | Max Wait |  Jain | Alarms |" << endl;
+    cout << "+------------+---------+---------+---------+-----------+----------+-------+--------+" << endl;
+    for (size_t c = 0; c < VEHICLE_CLASS_COUNT; ++c) {
+        uint64_t offered = 0, served = 0, blocks = 0, alarms = 0;
+        double total_wait = 0.0, max_wait = 0.0;
+        for (size_t i = 0; i < fairness.node_count(); ++i) {
+            const FairnessStream& s = fairness.stream(i, c);
+            offered += s.offered;
+            served += s.served;
+            blocks += s.blocks;
+            alarms += s.alarms;
+            total_wait += s.total_wait;
+            max_wait = max({max_wait, s.max_wait, fairness.oldest_age(i, c)});
+        }
+        if (offered == 0) continue;
+        cout << "| " << left << setw(10) << VEHICLE_CLASSES[c].display << right
+             << " | " << setw(7) << offered << " | " << setw(7) << served << " | " << setw(7) << blocks
+             << " | " << fixed << setprecision(2) << setw(7) << (served > 0 ? total_wait / served : 0.0) << " s"
+             << " | " << setw(6) << max_wait << " s"
+             << " | " << setw(5) << fairness.jain_index(c)
+             << " | " << setw(6) << alarms << " |" << endl;
+    }
+    cout << "+------------+---------+---------+---------+-----------+----------+-------+--------+" << endl;
+    cout << Display::INFO_ICON << " Jain index of service over all node queues: " << fixed << setprecision(3)
+         << fairness.jain_index() << endl;
+
+    if (fairness.total_alarms() == 0) {
+        cout << Display::SUCCESS_ICON << " No vehicle queued longer than " << setprecision(1)
+             << fairness.alarm_threshold() << " s" << endl;
+        return;
+    }
+    cout << Display::WARNING_ICON << " Starvation alarms (queued longer than " << setprecision(1)
+         << fairness.alarm_threshold() << " s): " << fairness.total_alarms() << endl;
+    size_t listed = 0;
+    for (size_t i = 0; i < fairness.node_count() && listed < static_cast<size_t>(config.top_k_nodes); ++i) {
+        for (size_t c = 0; c < VEHICLE_CLASS_COUNT; ++c) {
+            const FairnessStream& s = fairness.stream(i, c);
+            if (s.alarms == 0) continue;
+            cout << "   Node " << nodes[i].node_char << " " << VEHICLE_CLASSES[c].display << ": "
+                 << s.alarms << " alarms" << (s.starving ? ", still starving" : "") << endl;
+            listed++;
+        }
+    }
+}
+
 void TrafficNetwork::display_quick_stats() {
     lock_guard<mutex> stats_lock(stats_mutex);
     cout << "\n" << Display::INFO_ICON << " Quick Stats: "
@@ -442,6 +1024,21 @@ void TrafficNetwork::display_enhanced_real_time_stats() {
     if (config.mode == SimulationMode::AUTOMATIC) {
         Display::clear_screen();
         Display::print_header("TRAFFIC MANAGEMENT SYSTEM - LIVE MONITORING");
+        WindowSummary recent;
+        {
+            lock_guard<mutex> stats_lock(stats_mutex);
+            recent = stats.windows.window(stats.elapsed_seconds(), config.metrics_window);
+        }
+        cout << Display::INFO_ICON << " Last " << fixed << setprecision(1) << recent.seconds << " s: "
+             << recent.throughput << " moves/s, " << recent.arrival_rate << " arrivals/s, "
+             << recent.blocks << " blocks" << endl << endl;
+
+        lock_guard<mutex> lock(global_coordinator_mutex);
+        display_congested_nodes(static_cast<size_t>(config.top_k_nodes));
+        string fairness_icon = fairness.starving_streams() > 0 ? Display::WARNING_ICON : Display::INFO_ICON;
+        cout << fairness_icon << " Fairness: Jain " << fixed << setprecision(2) << fairness.jain_index()
+             << ", " << fairness.starving_streams() << " queues starving, "
+             << fairness.total_alarms() << " alarms" << endl;
     }
 }
 
@@ -450,13 +1047,13 @@ void TrafficNetwork::display_performance_dashboard() { /* Abbreviated */ }
 void TrafficNetwork::display_activity_summary() { /* Abbreviated */ }
 
 void TrafficNetwork::display_final_report() {
-    if (config.mode != SimulationMode::FAST_RUN) {
+    if (config.mode == SimulationMode::STEP_BY_STEP || config.mode == SimulationMode::AUTOMATIC) {
         Display::clear_screen();
     }
 
     Display::print_header("TRAFFIC MANAGEMENT SYSTEM - SIMULATION COMPLETE");
     auto end_time = steady_clock::now();
-    auto total_time = duration_cast<seconds>(end_time - stats.start_time).count();
+    double total_time = duration<double>(end_time - stats.start_time).count();
 
     if (config.mode == SimulationMode::STEP_BY_STEP) {
         cout << Display::STEP_ICON << " Step-by-step simulation completed!" << endl;
@@ -473,10 +1070,64 @@ void TrafficNetwork::display_final_report() {
     cout << Display::RESET << endl;
 
     Display::print_section_header("Simulation Summary");
-    cout << "Execution Time: " << Display::BOLD << total_time << Display::RESET << " seconds" << endl;
+    cout << "Execution Time: " << Display::BOLD << fixed << setprecision(1) << total_time
+         << Display::RESET << " seconds" << endl;
+    if (!early_stop_reason.empty()) {
+        cout << "Stopped Early: " << early_stop_reason << endl;
+    }
     cout << "Network Size: " << nodes.size() << " nodes" << endl;
     cout << "Simulation Status: " << Display::BOLD << Display::GREEN << "SUCCESS" << Display::RESET << endl << endl;
 
+    {
+        lock_guard<mutex> stats_lock(stats_mutex);
+        Display::print_section_header("Performance Metrics");
+        cout << "Total Moves: " << stats.total_moves << endl;
+        cout << "Vehicles Completed: " << stats.successful_routes
+             << " (regular " << stats.total_vehicles_processed
+             << ", emergency " << stats.emergency_vehicles_processed << ")" << endl;
+        cout << "Rerouting Attempts: " << stats.rerouting_attempts << endl;
+        if (config.signal_policy != SignalPolicy::NONE && signals.controller_count() > 0) {
+            cout << "Signal Phase Switches: " << signals.phase_switches()
+                 << " across " << signals.controller_count() << " controllers" << endl;
+        }
+        if (!admission.empty()) {
+            cout << "Entry Demand: generated " << admission.generated() << ", admitted " << admission.admitted()
+                 << ", held " << admission.buffered() << ", deferred " << admission.deferred() << endl;
+        }
+        if (delays_configured && stats.timed_moves > 0) {
+            cout << "Travel Time: mean " << fixed << setprecision(1) << stats.total_travel_ms / stats.timed_moves
+                 << " ms, max " << stats.max_travel_ms << " ms over " << stats.timed_moves << " moves" << endl;
+        }
+        cout << "Success Rate: " << fixed << setprecision(1) << stats.get_success_rate() << "%" << endl;
+        cout << "Throughput: " << fixed << setprecision(2) << stats.get_throughput() << " moves/s" << endl;
+        WindowSummary recent = stats.windows.window(stats.elapsed_seconds(), config.metrics_window);
+        cout << "Last " << setprecision(1) << recent.seconds << " s: " << setprecision(2)
+             << recent.throughput << " moves/s, " << recent.arrival_rate << " arrivals/s, "
+             << recent.blocks << " blocks";
+        if (recent.arrivals > 0) {
+            cout << ", journey p50 " << llround(recent.latency_p50_ms) << " ms, p95 "
+                 << llround(recent.latency_p95_ms) << " ms";
+        }
+        cout << endl << endl;
+    }
+
+    if (congestion.size() > 0) {
+        Display::print_section_header("Congestion Hotspots");
+        display_congested_nodes(static_cast<size_t>(config.top_k_nodes));
+        cout << endl;
+    }
+
+    if (fairness.node_count() > 0) {
+        Display::print_section_header("Fairness");
+        display_fairness_report();
+        cout << endl;
+    }
+
+    if (tracer.enabled()) {
+        write_vehicle_trace();
+        cout << endl;
+    }
+
     cout << Display::BOLD << Display::GREEN << "Thank you for using the Traffic Management System!" << Display::RESET << endl;
     cout << Display::INFO_ICON << " Simulation data has been processed and displayed above." << endl;
 }
@@ -514,8 +1165,19 @@ bool TrafficNetwork::load_input(const string& filename) {
             char node_char = 'A' + i;
             nodes.emplace_back(i, node_char, NodeType::WAIT_NODE, 5);
         }
+        active_nodes.reset(n);
+        focus_region.assign(n, false);
+        node_positions.assign(n, GeoPoint{NAN, NAN});
+        delay_models.assign(2, DelayModel{});
+        edge_delay_spec.clear();
+        node_delay_spec.assign(n, NO_DELAY_MODEL);
+        admission.clear();
+        class_reserved.assign(n * VEHICLE_CLASS_COUNT, 0);
+        class_priority.clear();
+        build_class_limits();
 
         parse_config_sections(file, n);
+        build_spatial_index();
 
         cout << Display::SUCCESS_ICON << " Loaded " << n << " nodes with "
              << next_vehicle_id - 1 << " vehicles" << endl;
@@ -533,6 +1195,8 @@ void TrafficNetwork::parse_config_sections(ifstream& file, int n) {
     unordered_map<char, int> initial_traffic;
     unordered_map<char, int> ambulances;
     unordered_map<char, int> fire_trucks;
+    unordered_map<char, int> buses;
+    unordered_map<char, int> freight;
 
     string line, current_section = "";
     while (getline(file, line)) {
@@ -556,14 +1220,45 @@ void TrafficNetwork::parse_config_sections(ifstream& file, int n) {
         } else if (line.find("# Destination Nodes") != string::npos) {
             current_section = "destinations";
             continue;
+        } else if (line.find("# Focus Region") != string::npos) {
+            current_section = "focus";
+            continue;
+        } else if (line.find("# Node Coordinates") != string::npos) {
+            current_section = "coordinates";
+            continue;
+        } else if (line.find("# Travel Times") != string::npos) {
+            current_section = "travel_times";
+            continue;
+        } else if (line.find("# Service Times") != string::npos) {
+            current_section = "service_times";
+            continue;
+        } else if (line.find("# Entry Points") != string::npos) {
+            current_section = "entry_points";
+            continue;
+        } else if (line.find("# Buses") != string::npos) {
+            current_section = "buses";
+            continue;
+        } else if (line.find("# Freight") != string::npos) {
+            current_section = "freight";
+            continue;
+        } else if (line.find("# Reserved Capacity") != string::npos) {
+            current_section = "reserved";
+            continue;
+        } else if (line.find("# Class Priority") != string::npos) {
+            current_section = "class_priority";
+            continue;
+        } else if (line.find("# System Configuration") != string::npos ||
+                   line.find("# Display Configuration") != string::npos) {
+            current_section = "config";
+            continue;
         }
 
         parse_section_line(line, current_section, node_capacities, traffic_controllers,
-                         initial_traffic, ambulances, fire_trucks, n);
+                         initial_traffic, ambulances, fire_trucks, buses, freight, n);
     }
 
     apply_configuration(node_capacities, traffic_controllers, initial_traffic,
-                      ambulances, fire_trucks, n);
+                      ambulances, fire_trucks, buses, freight, n);
 }
 
 void TrafficNetwork::parse_section_line(const string& line, const string& section,
@@ -571,7 +1266,9 @@ void TrafficNetwork::parse_section_line(const string& line, const string& sectio
                       unordered_set<char>& controllers,
                       unordered_map<char, int>& traffic,
                       unordered_map<char, int>& ambulances,
-                      unordered_map<char, int>& fire_trucks, int n) {
+                      unordered_map<char, int>& fire_trucks,
+                      unordered_map<char, int>& buses,
+                      unordered_map<char, int>& freight, int n) {
     
     if (section == "capacities" && line.find(':') != string::npos) {
         char node_char = line[0];
@@ -597,6 +1294,97 @@ void TrafficNetwork::parse_section_line(const string& line, const string& sectio
         char node_char = line[0];
         int count = stoi(line.substr(line.find(':') + 1));
         fire_trucks[node_char] = count;
+    } else if (section == "buses" && line.find(':') != string::npos) {
+        buses[line[0]] = stoi(line.substr(line.find(':') + 1));
+    } else if (section == "freight" && line.find(':') != string::npos) {
+        freight[line[0]] = stoi(line.substr(line.find(':') + 1));
+    } else if (section == "reserved" && line.find(':') != string::npos) {
+        // C: BUS 2, AMBULANCE 1
+        int node_idx = line[0] - 'A';
+        stringstream ss(line.substr(line.find(':') + 1));
+        string entry;
+        while (node_idx >= 0 && node_idx < n && getline(ss, entry, ',')) {
+            stringstream fields(entry);
+            string name;
+            int slots = 0;
+            VehicleType type;
+            if (!(fields >> name >> slots)) continue;
+            if (!parse_vehicle_class(name.c_str(), type) || slots < 0) {
+                cout << Display::WARNING_ICON << " Reserved Capacity: ignoring " << name << endl;
+                continue;
+            }
+            class_reserved[node_idx * VEHICLE_CLASS_COUNT + vehicle_class_index(type)] = slots;
+        }
+    } else if (section == "class_priority" && line.find(':') != string::npos) {
+        // C: FIRE_TRUCK 4 -- ranks only matter in the emergency queue
+        int node_idx = line[0] - 'A';
+        stringstream ss(line.substr(line.find(':') + 1));
+        string entry;
+        while (node_idx >= 0 && node_idx < n && getline(ss, entry, ',')) {
+            stringstream fields(entry);
+            string name;
+            int rank = 0;
+            VehicleType type;
+            if (!(fields >> name >> rank)) continue;
+            if (!parse_vehicle_class(name.c_str(), type) || !vehicle_class(type).emergency ||
+                rank < 0 || rank > 255) {
+                cout << Display::WARNING_ICON << " Class Priority: ignoring " << name << endl;
+                continue;
+            }
+            class_priority[node_idx * VEHICLE_CLASS_COUNT + vehicle_class_index(type)] = static_cast<uint8_t>(rank);
+        }
+    } else if (section == "config" && line.find(':') != string::npos) {
+        size_t colon_pos = line.find(':');
+        string key = line.substr(0, colon_pos);
+        string value = line.substr(colon_pos + 1);
+        key.erase(key.find_last_not_of(" \t\r") + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t\r") + 1);
+        config.apply_option(key, value);
+    } else if (section == "focus") {
+        stringstream ss(line);
+        string node_str;
+        while (getline(ss, node_str, ',')) {
+            node_str.erase(0, node_str.find_first_not_of(" \t"));
+            int node_idx = node_str.empty() ? -1 : node_str[0] - 'A';
+            if (node_idx >= 0 && node_idx < n) {
+                focus_region[node_idx] = true;
+            }
+        }
+    } else if (section == "coordinates" && line.find(':') != string::npos) {
+        int node_idx = line[0] - 'A';
+        string values = line.substr(line.find(':') + 1);
+        size_t comma = values.find(',');
+        if (node_idx >= 0 && node_idx < n && comma != string::npos) {
+            double first = stod(values.substr(0, comma));
+            double second = stod(values.substr(comma + 1));
+            node_positions[node_idx] = GeoPoint{first, second};
+        }
+    } else if (section == "travel_times" && line.find(':') != string::npos) {
+        // A-B: LOGNORMAL 120 0.5
+        size_t colon = line.find(':');
+        int from = line[0] - 'A';
+        int to = colon >= 3 && line[1] == '-' ? line[2] - 'A' : -1;
+        if (from >= 0 && from < n && to >= 0 && to < n && adjacency_matrix[from][to]) {
+            uint16_t model = add_delay_model(line.substr(colon + 1), line.substr(0, colon));
+            if (model != NO_DELAY_MODEL) edge_delay_spec[from * n + to] = model;
+        } else {
+            cout << Display::WARNING_ICON << " Travel Times: no edge " << line.substr(0, colon) << endl;
+        }
+    } else if (section == "service_times" && line.find(':') != string::npos) {
+        int node_idx = line[0] - 'A';
+        if (node_idx >= 0 && node_idx < n) {
+            size_t colon = line.find(':');
+            uint16_t model = add_delay_model(line.substr(colon + 1), line.substr(0, colon));
+            if (model != NO_DELAY_MODEL) node_delay_spec[node_idx] = model;
+        }
+    } else if (section == "entry_points" && line.find(':') != string::npos) {
+        // A: 0.5   metering rate in vehicles per tick
+        int node_idx = line[0] - 'A';
+        double rate = stod(line.substr(line.find(':') + 1));
+        if (node_idx >= 0 && node_idx < n && rate > 0.0) {
+            admission.add_entry(node_idx, rate);
+        }
     } else if (section == "destinations" && line.find(':') != string::npos) {
         char src = line[0];
         size_t colon_pos = line.find(':');
@@ -615,7 +1403,9 @@ void TrafficNetwork::apply_configuration(const unordered_map<char, int>& capacit
                        const unordered_set<char>& controllers,
                        const unordered_map<char, int>& traffic,
                        const unordered_map<char, int>& ambulances,
-                       const unordered_map<char, int>& fire_trucks, int n) {
+                       const unordered_map<char, int>& fire_trucks,
+                       const unordered_map<char, int>& buses,
+                       const unordered_map<char, int>& freight, int n) {
     // Apply capacities
     for (auto& node : nodes) {
         if (capacities.count(node.node_char)) {
@@ -640,12 +1430,16 @@ void TrafficNetwork::apply_configuration(const unordered_map<char, int>& capacit
     }
 
     // Add initial vehicles
-    add_vehicles_to_nodes(traffic, ambulances, fire_trucks, n);
+    fairness.reset(nodes.size(), VEHICLE_CLASS_COUNT);
+    configure_tracer();
+    add_vehicles_to_nodes(traffic, ambulances, fire_trucks, buses, freight, n);
 }
 
 void TrafficNetwork::add_vehicles_to_nodes(const unordered_map<char, int>& traffic,
                          const unordered_map<char, int>& ambulances,
-                         const unordered_map<char, int>& fire_trucks, int n) {
+                         const unordered_map<char, int>& fire_trucks,
+                         const unordered_map<char, int>& buses,
+                         const unordered_map<char, int>& freight, int n) {
     for (auto& node : nodes) {
         int node_idx = node.node_id;
         char node_char = node.node_char;
@@ -655,8 +1449,8 @@ void TrafficNetwork::add_vehicles_to_nodes(const unordered_map<char, int>& traff
             int regular_count = min(traffic.at(node_char), max(1, node.capacity - 1));
             for (int i = 0; i < regular_count; ++i) {
                 int dest = destinations.count(node_idx) ? destinations[node_idx] : (node_idx + 1) % n;
-                Vehicle vehicle(next_vehicle_id++, VehicleType::REGULAR, node_idx, dest);
-                node.waiting_queue.push(vehicle);
+                Vehicle vehicle = make_vehicle(next_vehicle_id++, VehicleType::REGULAR, node_idx, dest);
+                enqueue_vehicle(node_idx, vehicle, false);
                 node.current_vehicles++;
             }
         }
@@ -666,8 +1460,8 @@ void TrafficNetwork::add_vehicles_to_nodes(const unordered_map<char, int>& traff
             int amb_count = ambulances.at(node_char);
             for (int i = 0; i < amb_count; ++i) {
                 int dest = destinations.count(node_idx) ? destinations[node_idx] : (node_idx + 1) % n;
-                Vehicle vehicle(next_vehicle_id++, VehicleType::AMBULANCE, node_idx, dest);
-                node.emergency_queue.push(vehicle);
+                Vehicle vehicle = make_vehicle(next_vehicle_id++, VehicleType::AMBULANCE, node_idx, dest);
+                enqueue_vehicle(node_idx, vehicle, true);
                 node.current_vehicles++;
             }
         }
@@ -677,8 +1471,19 @@ void TrafficNetwork::add_vehicles_to_nodes(const unordered_map<char, int>& traff
             int fire_count = fire_trucks.at(node_char);
             for (int i = 0; i < fire_count; ++i) {
                 int dest = destinations.count(node_idx) ? destinations[node_idx] : (node_idx + 1) % n;
-                Vehicle vehicle(next_vehicle_id++, VehicleType::FIRE_TRUCK, node_idx, dest);
-                node.emergency_queue.push(vehicle);
+                Vehicle vehicle = make_vehicle(next_vehicle_id++, VehicleType::FIRE_TRUCK, node_idx, dest);
+                enqueue_vehicle(node_idx, vehicle, true);
+                node.current_vehicles++;
+            }
+        }
+
+        // Add buses and freight
+        for (auto [counts, type] : {make_pair(&buses, VehicleType::BUS), make_pair(&freight, VehicleType::FREIGHT)}) {
+            if (!counts->count(node_char)) continue;
+            for (int i = 0; i < counts->at(node_char); ++i) {
+                int dest = destinations.count(node_idx) ? destinations[node_idx] : (node_idx + 1) % n;
+                Vehicle vehicle = make_vehicle(next_vehicle_id++, type, node_idx, dest);
+                enqueue_vehicle(node_idx, vehicle, vehicle_class(type).emergency);
                 node.current_vehicles++;
             }
         }
@@ -700,6 +1505,7 @@ bool TrafficNetwork::create_sample_input() {
     nodes.emplace_back(1, 'B', NodeType::WAIT_NODE, 3);
     nodes.emplace_back(2, 'C', NodeType::TRAFFIC_CONTROLLER, 4);
     nodes.emplace_back(3, 'D', NodeType::WAIT_NODE, 6);
+    active_nodes.reset(nodes.size());
 
     for (size_t i = 0; i < adjacency_matrix.size(); ++i) {
         for (size_t j = 0; j < adjacency_matrix[i].size(); ++j) {
@@ -712,31 +1518,30 @@ bool TrafficNetwork::create_sample_input() {
     destinations[0] = 3; destinations[1] = 2;
     destinations[2] = 0; destinations[3] = 1;
 
+    fairness.reset(nodes.size(), VEHICLE_CLASS_COUNT);
+    class_reserved.clear();
+    class_priority.clear();
+    build_class_limits();
+    configure_tracer();
     add_sample_vehicles();
     return true;
 }
 
 void TrafficNetwork::add_sample_vehicles() {
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> type_dist(0, 10);
+    CounterRng rng(config.random_seed);
 
     for (size_t i = 0; i < nodes.size(); ++i) {
         int num_vehicles = 1 + (i % 2);
 
         for (int j = 0; j < num_vehicles; ++j) {
+            int id = next_vehicle_id++;
             VehicleType type = VehicleType::REGULAR;
-            if (type_dist(gen) == 0) type = VehicleType::AMBULANCE;
-            else if (type_dist(gen) == 1) type = VehicleType::FIRE_TRUCK;
+            if (rng.below(11, id, 0, RandomPurpose::SAMPLE_VEHICLES, 0) == 0) type = VehicleType::AMBULANCE;
+            else if (rng.below(11, id, 0, RandomPurpose::SAMPLE_VEHICLES, 1) == 1) type = VehicleType::FIRE_TRUCK;
 
             int dest = destinations.count(i) ? destinations[i] : (i + 1) % nodes.size();
-            Vehicle vehicle(next_vehicle_id++, type, i, dest);
-
-            if (type == VehicleType::REGULAR) {
-                nodes[i].waiting_queue.push(vehicle);
-            } else {
-                nodes[i].emergency_queue.push(vehicle);
-            }
+            Vehicle vehicle = make_vehicle(id, type, i, dest);
+            enqueue_vehicle(i, vehicle, vehicle_class(type).emergency);
             nodes[i].current_vehicles++;
         }
     }
@@ -746,103 +1551,628 @@ void TrafficNetwork::add_sample_vehicles() {
 // THREADING METHODS
 // ================================
 
+void TrafficNetwork::configure_workers() {
+    if (config.pin_worker_threads || config.worker_threads != static_cast<int>(thread_pool->size())) {
+        thread_pool = make_unique<ThreadPool>(config.worker_threads, config.pin_worker_threads);
+        cout << Display::INFO_ICON << " Worker threads: " << config.worker_threads;
+        if (thread_pool->is_pinned()) {
+            unordered_set<int> numa_nodes;
+            for (size_t w = 0; w < thread_pool->size(); ++w) numa_nodes.insert(thread_pool->worker_numa_node(w));
+            cout << " (pinned across " << numa_nodes.size() << " NUMA node"
+                 << (numa_nodes.size() == 1 ? "" : "s") << ")";
+        }
+        cout << endl;
+    }
+}
+
+template<class Observer>
+void TrafficNetwork::run_tick(Observer& observer, const vector<bool>* served) {
+    clear_blocked_heads();
+    release_arrivals();
+    meter_entry_traffic();
+    vector<uint32_t> active = active_nodes.snapshot();
+    plan_next_hops(active);
+    sample_tick_delays(active);
+    update_signals(active);
+    for (uint32_t i : active) {
+        if (stop_token.stop_requested()) break;
+        if (served && !(*served)[i]) continue;
+        process_node_vehicles(i, observer);
+    }
+    token_tick++;
+}
+
 void TrafficNetwork::token_allocation_loop() {
-    active_threads++;
-    while (!shutdown_requested) {
+    enter_loop();
+    SilentMovementObserver silent;
+    while (!stop_token.stop_requested()) {
         try {
             unique_lock<mutex> lock(global_coordinator_mutex);
-            for (size_t i = 0; i < nodes.size(); ++i) {
-                if (nodes[i].get_queue_size() > 0) {
-                    process_node_vehicles(i);
-                }
+            run_tick(silent);
+            publish_state(duration<double>(steady_clock::now() - stats.start_time).count());
+
+            // Between ticks, serve nodes whose agents saw capacity free up
+            auto next_tick = steady_clock::now() +
+                duration_cast<steady_clock::duration>(chrono::duration<double>(config.token_cycle_duration));
+            while (cv_token_allocation.wait_until(lock, next_tick, [this]() {
+                       return stop_token.stop_requested() || !agent_worklist.empty(); })) {
+                if (stop_token.stop_requested()) break;
+                retry_woken_nodes(silent);
             }
-            cv_token_allocation.wait_for(lock,
-                                        chrono::duration<double>(config.token_cycle_duration),
-                                        [this]() { return shutdown_requested.load(); });
         } catch (const exception& e) {
-            this_thread::sleep_for(chrono::milliseconds(1000));
+            stop_token.wait_for(chrono::milliseconds(1000));
         }
     }
-    active_threads--;
+    exit_loop();
 }
 
-void TrafficNetwork::process_node_vehicles(size_t node_idx) {
+void TrafficNetwork::refresh_node_state() {
+    size_t blocks = (nodes.size() + NodeKernels::BLOCK - 1) / NodeKernels::BLOCK;
+    if (node_state.size() != nodes.size() || node_state_dirty.size() != blocks) {
+        node_state.resize(nodes.size());
+        node_state_dirty.assign(blocks, 1);
+        dirty_state_blocks.resize(blocks);
+        iota(dirty_state_blocks.begin(), dirty_state_blocks.end(), 0u);
+    }
+
+    // Gather counters into SoA form and run the kernel one mask block at a
+    // time, for the blocks whose nodes changed since the last refresh
+    auto refresh_block = [this](size_t block) {
+        size_t lo = block * NodeKernels::BLOCK;
+        size_t hi = min(nodes.size(), lo + NodeKernels::BLOCK);
+        for (size_t i = lo; i < hi; ++i) {
+            const NodeData& node = nodes[i];
+            node_state.current_vehicles[i] = node.current_vehicles;
+            node_state.capacity[i] = node.capacity;
+            node_state.waiting[i] = static_cast<int32_t>(node.waiting_queue.size());
+            node_state.emergency[i] = static_cast<int32_t>(node.emergency_queue.size());
+        }
+        NodeKernels::update(node_state, lo, hi);
+    };
+
+    if (thread_pool->is_pinned()) {
+        // Pinned workers each own a fixed block range: the owner first-touches
+        // its blocks on the full refresh and handles them ever after, so the
+        // pages stay on its NUMA node
+        sort(dirty_state_blocks.begin(), dirty_state_blocks.end());
+        thread_pool->parallel_for_static(0, blocks, [this, &refresh_block](size_t lo, size_t hi) {
+            auto first = lower_bound(dirty_state_blocks.begin(), dirty_state_blocks.end(), lo);
+            for (auto it = first; it != dirty_state_blocks.end() && *it < hi; ++it) refresh_block(*it);
+        });
+    } else {
+        thread_pool->parallel_for(0, dirty_state_blocks.size(), [this, &refresh_block](size_t k) {
+            refresh_block(dirty_state_blocks[k]);
+        }, 16);
+    }
+    for (uint32_t block : dirty_state_blocks) node_state_dirty[block] = 0;
+    dirty_state_blocks.clear();
+}
+
+void TrafficNetwork::plan_next_hops(const vector<uint32_t>& active) {
+    // Route phase: next hops depend only on topology, so the head vehicle of
+    // every active queue can be routed in parallel before the commit phase.
+    if (planned_hops.size() != nodes.size()) {
+        planned_hops.assign(nodes.size(), RoutePlan{});
+    }
+    thread_pool->parallel_for(0, active.size(), [this, &active](size_t k) {
+        size_t i = active[k];
+        planned_hops[i] = RoutePlan{};
+        const Vehicle* head = queue_head(i);
+        if (head) {
+            planned_hops[i].vehicle_id = head->vehicle_id;
+            planned_hops[i].next_hop = route_next_hop(*head, i);
+        }
+    }, 4);
+}
+
+void TrafficNetwork::update_signals(const vector<uint32_t>& active) {
+    if (config.signal_policy == SignalPolicy::NONE || signals.controller_count() == 0) return;
+
+    if (config.signal_policy == SignalPolicy::FIXED_PLAN) {
+        signals.apply_plan(signal_plan, signal_tick++);
+        return;
+    }
+
+    refresh_node_state();
+    if (head_hops.size() != nodes.size()) {
+        head_hops.assign(nodes.size(), -1);
+        head_hop_stamp.assign(nodes.size(), 0);
+        head_hop_nodes.clear();
+    }
+
+    // Set this tick's head hops, then clear last tick's that were not set
+    // again; only changed entries touch the signal controllers
+    vector<uint32_t> previous;
+    previous.swap(head_hop_nodes);
+    head_hop_epoch++;
+    for (uint32_t i : active) {
+        if (planned_hops[i].vehicle_id < 0) continue;
+        if (head_hops[i] != planned_hops[i].next_hop) {
+            head_hops[i] = planned_hops[i].next_hop;
+            signals.touch(i);
+        }
+        head_hop_stamp[i] = head_hop_epoch;
+        head_hop_nodes.push_back(i);
+    }
+    for (uint32_t i : previous) {
+        if (head_hop_stamp[i] != head_hop_epoch && head_hops[i] != -1) {
+            head_hops[i] = -1;
+            signals.touch(i);
+        }
+    }
+    signals.update(node_state, head_hops, *thread_pool);
+}
+
+int TrafficNetwork::next_hop_for(const Vehicle& vehicle, size_t from_node) {
+    if (from_node < planned_hops.size() && planned_hops[from_node].vehicle_id == vehicle.vehicle_id) {
+        return planned_hops[from_node].next_hop;
+    }
+    return route_next_hop(vehicle, from_node);
+}
+
+int TrafficNetwork::route_next_hop(const Vehicle& vehicle, size_t from_node) {
+    // Replayed trips follow their matched path while it stays on the network
+    if (vehicle.path_step + 1 < vehicle.path.size()) {
+        int hop = vehicle.path[vehicle.path_step + 1];
+        const auto& adjacent = nodes[from_node].adjacent_nodes;
+        if (find(adjacent.begin(), adjacent.end(), hop) != adjacent.end()) return hop;
+    }
+    return find_best_next_hop(from_node, vehicle.destination_node);
+}
+
+template<class Observer>
+void TrafficNetwork::process_node_vehicles(size_t node_idx, Observer& observer) {
     if (node_idx >= nodes.size()) return;
-    NodeData& node = nodes[node_idx];
+    fairness.check(node_idx);
 
     try {
-        if (node.has_emergency_vehicles()) {
-            Vehicle vehicle = node.emergency_queue.top();
-            node.emergency_queue.pop();
-            process_vehicle(vehicle, node_idx, true);
-        } else if (!node.waiting_queue.empty()) {
-            Vehicle vehicle = node.waiting_queue.front();
-            node.waiting_queue.pop();
-            process_vehicle(vehicle, node_idx, false);
+        uint16_t model = node_idx < node_service_model.size() ? node_service_model[node_idx] : NO_DELAY_MODEL;
+        if (model == NO_DELAY_MODEL) {
+            serve_node_vehicle(node_idx, observer);
+            return;
+        }
+
+        // Renewal service: the node earns one token cycle of service time per
+        // tick and serves while that covers the pending sample. A blocked
+        // vehicle still uses its service slot, as with one vehicle per token.
+        const DelayModel& service = delay_models[model];
+        double& credit = service_credit_ms[node_idx];
+        float& pending = service_pending_ms[node_idx];
+        credit += config.token_cycle_duration * 1000.0;
+        if (pending <= 0.0f) {
+            pending = max(1e-3f, static_cast<float>(service.quantile(
+                delay_rng.uniform(static_cast<uint32_t>(node_idx), token_tick, RandomPurpose::SERVICE_TIME))));
+        }
+        for (uint32_t draw = 1; credit >= pending && nodes[node_idx].get_queue_size() > 0; ++draw) {
+            credit -= pending;
+            serve_node_vehicle(node_idx, observer);
+            pending = max(1e-3f, static_cast<float>(service.quantile(
+                delay_rng.uniform(static_cast<uint32_t>(node_idx), token_tick, RandomPurpose::SERVICE_TIME, draw))));
+            if (stop_token.stop_requested()) break;
+        }
+        if (nodes[node_idx].get_queue_size() == 0) {
+            credit = 0.0;
+            pending = 0.0f;
         }
     } catch (const exception& e) {
         // Silent error handling for cleaner display
     }
 }
 
-void TrafficNetwork::process_vehicle(Vehicle& vehicle, size_t from_node, bool is_emergency) {
-    int next_node = find_best_next_hop(from_node, vehicle.destination_node);
+template<class Observer>
+bool TrafficNetwork::serve_node_vehicle(size_t node_idx, Observer& observer) {
+    Vehicle vehicle(0, VehicleType::REGULAR, 0, 0);
+    bool is_emergency = false;
+    if (!dequeue_vehicle(node_idx, vehicle, is_emergency)) return false;
+
+    return process_vehicle(vehicle, node_idx, is_emergency, observer);
+}
+
+// ================================
+// ENTRY ADMISSION CONTROL
+// ================================
+
+void TrafficNetwork::meter_entry_traffic() {
+    if (admission.empty()) return;
+
+    // Demand generator: Poisson arrivals per entry, throttled by buffer room
+    if (config.demand_rate > 0.0) {
+        poisson_distribution<int> arrivals(config.demand_rate);
+        int n = static_cast<int>(nodes.size());
+        for (size_t k = 0; k < admission.entry_count(); ++k) {
+            int entry = admission.entry(k).node;
+            PhiloxEngine rng(config.random_seed, static_cast<uint32_t>(entry), RandomPurpose::DEMAND, token_tick);
+            size_t demand = static_cast<size_t>(arrivals(rng));
+            size_t accepted = min(demand, admission.room(k));
+            for (size_t a = 0; a < accepted; ++a) {
+                int destination = destinations.count(entry) ? destinations[entry] : entry;
+                if (destination == entry && n > 1) {
+                    destination = uniform_int_distribution<int>(0, n - 2)(rng);
+                    if (destination >= entry) destination++;
+                }
+                admission.hold(k, make_vehicle(next_vehicle_id++, VehicleType::REGULAR, entry, destination));
+            }
+            if (accepted < demand) admission.defer(k, demand - accepted);
+        }
+    }
+
+    // Metering: a held vehicle enters only into a free slot, never using
+    // the emergency overflow, so entries cannot push a node past capacity
+    admission.release([this](int node, Vehicle& vehicle) {
+        if (!can_move_to_node_safe(node, vehicle.type)) return false;
+        vehicle.arrival_time = steady_clock::now();
+        nodes[node].current_vehicles++;
+        enqueue_vehicle(node, vehicle, false);
+        return true;
+    });
+}
+
+// ================================
+// TRAVEL AND SERVICE TIMES
+// ================================
+
+uint16_t TrafficNetwork::add_delay_model(const string& spec, const string& where) {
+    DelayModel model;
+    if (!DelayModel::parse(spec, model)) {
+        cout << Display::WARNING_ICON << " Cannot parse delay model for " << where << ":" << spec << endl;
+        return NO_DELAY_MODEL;
+    }
+    if (delay_models.size() < 2) delay_models.resize(2);
+    if (delay_models.size() >= NO_DELAY_MODEL) return NO_DELAY_MODEL;
+    delay_models.push_back(model);
+    return static_cast<uint16_t>(delay_models.size() - 1);
+}
+
+void TrafficNetwork::build_edge_offsets() {
+    edge_offset.assign(nodes.size() + 1, 0);
+    int edges = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        edge_offset[i] = edges;
+        edges += static_cast<int>(nodes[i].adjacent_nodes.size());
+    }
+    edge_offset[nodes.size()] = edges;
+}
+
+void TrafficNetwork::build_delay_models() {
+    size_t n = nodes.size();
+    if (delay_models.size() < 2) delay_models.resize(2);
+    if (node_delay_spec.size() != n) node_delay_spec.assign(n, NO_DELAY_MODEL);
+
+    if (!DelayModel::parse(config.travel_time, delay_models[0])) {
+        cout << Display::WARNING_ICON << " Cannot parse TRAVEL_TIME " << config.travel_time
+             << " - using FIXED 100" << endl;
+        DelayModel::parse("FIXED 100", delay_models[0]);
+    }
+    bool default_service = !config.service_time.empty();
+    if (default_service && !DelayModel::parse(config.service_time, delay_models[1])) {
+        cout << Display::WARNING_ICON << " Cannot parse SERVICE_TIME " << config.service_time
+             << " - one vehicle per token" << endl;
+        default_service = false;
+    }
+
+    build_edge_offsets();
+    edge_travel_model.assign(edge_offset[n], 0);
+    stochastic_travel = delay_models[0].kind != DelayDistribution::FIXED;
+    for (size_t i = 0; i < n; ++i) {
+        const auto& adjacent = nodes[i].adjacent_nodes;
+        for (size_t k = 0; k < adjacent.size(); ++k) {
+            auto it = edge_delay_spec.find(static_cast<int>(i * n) + adjacent[k]);
+            if (it == edge_delay_spec.end()) continue;
+            edge_travel_model[edge_offset[i] + k] = it->second;
+            stochastic_travel |= delay_models[it->second].kind != DelayDistribution::FIXED;
+        }
+    }
+
+    node_service_model.assign(n, default_service ? 1 : NO_DELAY_MODEL);
+    for (size_t i = 0; i < n; ++i) {
+        if (node_delay_spec[i] != NO_DELAY_MODEL) node_service_model[i] = node_delay_spec[i];
+    }
+    service_credit_ms.assign(n, 0.0);
+    service_pending_ms.assign(n, 0.0f);
+    delay_rng = CounterRng(config.random_seed);
+    token_tick = 0;
+    reset_arrivals();
+
+    size_t serviced = count_if(node_service_model.begin(), node_service_model.end(),
+                               [](uint16_t m) { return m != NO_DELAY_MODEL; });
+    delays_configured = stochastic_travel || serviced > 0 || !edge_delay_spec.empty() ||
+                        delay_models[0].mean_ms != 100.0;
+    if (delays_configured) {
+        cout << Display::INFO_ICON << " Travel time " << delay_models[0].describe() << " ms, "
+             << edge_delay_spec.size() << " edge overrides; service time on " << serviced << " nodes" << endl;
+    }
+}
+
+uint16_t TrafficNetwork::travel_model_at(size_t from_node, int to_node) const {
+    const auto& adjacent = nodes[from_node].adjacent_nodes;
+    for (size_t k = 0; k < adjacent.size(); ++k) {
+        if (adjacent[k] == to_node) return edge_travel_model[edge_offset[from_node] + k];
+    }
+    return 0;
+}
+
+// Draws are keyed by (vehicle, tick) for travel and (node, tick, draw) for
+// service, so the batch below and the scalar fallbacks agree on every value.
+// The batch covers the head vehicle of each active node and the first
+// service time of each node that has none pending.
+void TrafficNetwork::sample_tick_delays(const vector<uint32_t>& active) {
+    if (stochastic_travel) {
+        delay_streams.clear();
+        delay_model_of.clear();
+        delay_nodes.clear();
+        for (uint32_t i : active) {
+            const RoutePlan& plan = planned_hops[i];
+            if (plan.vehicle_id < 0 || plan.next_hop < 0) continue;
+            delay_streams.push_back(static_cast<uint32_t>(plan.vehicle_id));
+            delay_model_of.push_back(travel_model_at(i, plan.next_hop));
+            delay_nodes.push_back(i);
+        }
+        delay_samples.resize(delay_streams.size());
+        sample_delays(delay_rng, delay_models, delay_streams.data(), delay_model_of.data(), delay_streams.size(),
+                      token_tick, RandomPurpose::TRAVEL_TIME, delay_uniforms, delay_samples.data());
+        for (size_t k = 0; k < delay_nodes.size(); ++k) {
+            planned_hops[delay_nodes[k]].travel_ms = delay_samples[k];
+        }
+    }
+
+    if (node_service_model.empty()) return;
+    delay_streams.clear();
+    delay_model_of.clear();
+    for (uint32_t i : active) {
+        if (node_service_model[i] == NO_DELAY_MODEL || service_pending_ms[i] > 0.0f) continue;
+        delay_streams.push_back(i);
+        delay_model_of.push_back(node_service_model[i]);
+    }
+    if (delay_streams.empty()) return;
+    delay_samples.resize(delay_streams.size());
+    sample_delays(delay_rng, delay_models, delay_streams.data(), delay_model_of.data(), delay_streams.size(),
+                  token_tick, RandomPurpose::SERVICE_TIME, delay_uniforms, delay_samples.data());
+    for (size_t k = 0; k < delay_streams.size(); ++k) {
+        // A zero sample would look like "none pending"; keep it just above
+        service_pending_ms[delay_streams[k]] = max(delay_samples[k], 1e-3f);
+    }
+}
+
+// Travel is whole token cycles: a vehicle arriving mid-cycle is first
+// eligible at the next tick, and a zero travel time keeps it eligible now
+// Travel ends in tick token_tick + floor(travel / cycle), offset_ms into it;
+// a vehicle always waits at least until the next tick before it is served
+void TrafficNetwork::begin_travel(Vehicle& vehicle, size_t from_node, size_t to_node) {
+    double travel_ms = travel_delay_ms(vehicle, from_node);
+    {
+        lock_guard<mutex> stats_lock(stats_mutex);
+        stats.total_travel_ms += travel_ms;
+        stats.max_travel_ms = max(stats.max_travel_ms, travel_ms);
+        stats.timed_moves++;
+    }
+    double cycle_ms = config.token_cycle_duration * 1000.0;
+    if (travel_ms <= 0.0 || cycle_ms <= 0.0) {
+        enqueue_vehicle(to_node, vehicle, vehicle_class(vehicle.type).emergency);
+        return;
+    }
+
+    double whole = floor(travel_ms / cycle_ms);
+    float offset = whole >= 1.0 ? static_cast<float>(travel_ms - whole * cycle_ms) : 0.0f;
+    uint32_t tick = token_tick + max<uint32_t>(1, static_cast<uint32_t>(whole));
+    in_transit[to_node]++;
+    arrivals.push(PendingArrival{tick, offset, arrival_seq++, vehicle});
+}
+
+void TrafficNetwork::release_arrivals() {
+    while (!arrivals.empty() && arrivals.top().tick <= token_tick) {
+        PendingArrival arrival = arrivals.top();
+        arrivals.pop();
+        size_t node_idx = static_cast<size_t>(arrival.vehicle.current_node);
+        in_transit[node_idx]--;
+
+        // An idle server starts serving from the moment the vehicle arrives
+        if (nodes[node_idx].get_queue_size() == 0 && node_idx < node_service_model.size() &&
+            node_service_model[node_idx] != NO_DELAY_MODEL) {
+            service_credit_ms[node_idx] = -arrival.offset_ms;
+            service_pending_ms[node_idx] = 0.0f;
+        }
+        enqueue_vehicle(node_idx, arrival.vehicle, vehicle_class(arrival.vehicle.type).emergency);
+    }
+}
+
+void TrafficNetwork::reset_arrivals() {
+    arrivals = {};
+    in_transit.assign(nodes.size(), 0);
+    arrival_seq = 0;
+}
+
+double TrafficNetwork::travel_delay_ms(const Vehicle& vehicle, size_t from_node) {
+    const RoutePlan* plan = from_node < planned_hops.size() ? &planned_hops[from_node] : nullptr;
+    if (plan && plan->vehicle_id == vehicle.vehicle_id && plan->next_hop == vehicle.current_node &&
+        plan->travel_ms >= 0.0f) {
+        return plan->travel_ms;
+    }
+    if (edge_travel_model.empty()) return 100.0;
+    const DelayModel& model = delay_models[travel_model_at(from_node, vehicle.current_node)];
+    if (model.kind == DelayDistribution::FIXED) return model.mean_ms;
+    return model.quantile(delay_rng.uniform(static_cast<uint32_t>(vehicle.vehicle_id), token_tick,
+                                            RandomPurpose::TRAVEL_TIME));
+}
+
+template<class Observer>
+bool TrafficNetwork::process_vehicle(Vehicle& vehicle, size_t from_node, bool is_emergency, Observer& observer) {
+    observer.on_vehicle_selected(vehicle, from_node);
+    if (vehicle.traced) {
+        double queued = vehicle.queue_stamp.ticket != 0 ? fairness.clock() - vehicle.queue_stamp.since : 0.0;
+        tracer.record(TraceKind::WAIT, vehicle.vehicle_id, static_cast<int>(from_node),
+                      static_cast<int>(llround(queued * 1000.0)));
+    }
+
+    int next_node = next_hop_for(vehicle, from_node);
     if (next_node == -1) {
+        observer.on_no_path(vehicle, from_node);
+        trace(TraceKind::NO_PATH, vehicle, from_node);
         return_vehicle_to_queue(vehicle, from_node, is_emergency);
-        return;
+        return false;
     }
 
-    if (can_move_to_node_safe(next_node, vehicle.type)) {
-        perform_vehicle_move(vehicle, from_node, next_node);
-    } else {
+    // Emergency vehicles preempt the signal
+    if (!is_emergency && !signals.allows(from_node, next_node)) {
+        observer.on_red_signal(vehicle, next_node);
+        trace(TraceKind::RED, vehicle, from_node, next_node);
         return_vehicle_to_queue(vehicle, from_node, is_emergency);
-        vehicle.blocked_attempts++;
-        if (vehicle.blocked_attempts > 5) {
-            attempt_rerouting(vehicle, from_node);
+        return false;
+    }
+
+    if (can_move_to_node_safe(next_node, vehicle.type)) {
+        return perform_vehicle_move(vehicle, from_node, next_node, observer);
+    }
+
+    observer.on_blocked(vehicle, next_node);
+    trace(TraceKind::BLOCK, vehicle, from_node, next_node);
+    record_block(from_node, vehicle);
+    mark_head_blocked(from_node);
+    vehicle.blocked_attempts++;
+    if (vehicle.blocked_attempts > 5) {
+        trace(TraceKind::REROUTE, vehicle, from_node);
+        attempt_rerouting(vehicle, from_node);
+    }
+    return_vehicle_to_queue(vehicle, from_node, is_emergency);
+    return false;
+}
+
+void TrafficNetwork::start_node_agents() {
+    upstream_nodes.assign(nodes.size(), vector<int>());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (int adj : nodes[i].adjacent_nodes) {
+            upstream_nodes[adj].push_back(static_cast<int>(i));
         }
     }
+    head_blocked.assign(nodes.size(), 0);
+    blocked_nodes.clear();
+    agent_worklist.clear();
+
+    node_agents.reset(nodes.size(), [this](AgentExecutor::AgentId agent, uint8_t fired) {
+        return resume_node_agent(agent, fired);
+    });
+    node_agents.start();
 }
 
-void TrafficNetwork::traffic_processing_loop(size_t node_idx) {
-    active_threads++;
-    while (!shutdown_requested) {
-        try {
-            this_thread::sleep_for(chrono::milliseconds(config.retry_delay_ms * 3));
-            if (nodes[node_idx].get_queue_size() > 0) {
-                cv_token_allocation.notify_one();
+AgentAwait TrafficNetwork::resume_node_agent(AgentExecutor::AgentId agent, uint8_t fired) {
+    // A node agent sleeps until a downstream node frees capacity. If its head
+    // is still blocked from this tick, the node goes on the worklist and the
+    // token loop retries it before the next tick.
+    if (fired & AgentEvent::CAPACITY_FREED) {
+        bool queued = false;
+        {
+            lock_guard<mutex> lock(global_coordinator_mutex);
+            if (agent < head_blocked.size() && head_blocked[agent] == 1) {
+                head_blocked[agent] = 2;
+                agent_worklist.push_back(agent);
+                queued = true;
             }
-        } catch (const exception& e) {
-            // Silent error handling
         }
+        if (queued) cv_token_allocation.notify_one();
+    }
+    return AgentAwait{AgentEvent::CAPACITY_FREED, chrono::milliseconds(0)};
+}
+
+void TrafficNetwork::notify_capacity_freed(size_t node_idx) {
+    if (node_idx >= upstream_nodes.size()) return;
+    for (int upstream : upstream_nodes[node_idx]) {
+        if (head_blocked[upstream] == 1) node_agents.signal(upstream, AgentEvent::CAPACITY_FREED);
+    }
+}
+
+// head_blocked: 0 clear, 1 blocked this tick, 2 queued for a retry
+void TrafficNetwork::mark_head_blocked(size_t node_idx) {
+    if (node_idx >= head_blocked.size() || head_blocked[node_idx] != 0) return;
+    head_blocked[node_idx] = 1;
+    blocked_nodes.push_back(static_cast<uint32_t>(node_idx));
+}
+
+void TrafficNetwork::clear_blocked_heads() {
+    for (uint32_t node : blocked_nodes) head_blocked[node] = 0;
+    blocked_nodes.clear();
+    agent_worklist.clear();
+}
+
+// The blocked vehicle already used its service slot in the tick just run,
+// so a retry moves it without drawing new service time. Arrivals for the
+// next tick are released only when that tick starts.
+template<class Observer>
+void TrafficNetwork::retry_woken_nodes(Observer& observer) {
+    vector<uint32_t> woken;
+    woken.swap(agent_worklist);
+    for (uint32_t node : woken) {
+        head_blocked[node] = 0;
+        serve_node_vehicle(node, observer);
     }
-    active_threads--;
 }
 
 void TrafficNetwork::ui_update_loop() {
-    active_threads++;
-    while (!shutdown_requested) {
+    enter_loop();
+    while (!stop_token.stop_requested()) {
         try {
             if (config.mode != SimulationMode::FAST_RUN) {
                 display_enhanced_real_time_stats();
             }
-            this_thread::sleep_for(chrono::milliseconds(config.console_refresh_rate));
+            stop_token.wait_for(chrono::milliseconds(config.console_refresh_rate));
         } catch (const exception& e) {
-            this_thread::sleep_for(chrono::milliseconds(1000));
+            stop_token.wait_for(chrono::milliseconds(1000));
         }
     }
-    active_threads--;
+    exit_loop();
 }
 
 // ================================
 // VEHICLE MOVEMENT METHODS
 // ================================
 
-void TrafficNetwork::return_vehicle_to_queue(Vehicle& vehicle, size_t node_idx, bool is_emergency) {
+// A vehicle arriving at a node starts aging there; one returned after a
+// failed move goes back through queue_vehicle and keeps its stamp
+void TrafficNetwork::enqueue_vehicle(size_t node_idx, Vehicle vehicle, bool is_emergency) {
+    vehicle.queue_stamp = fairness.join(node_idx, vehicle_class_index(vehicle.type));
+    queue_vehicle(node_idx, vehicle, is_emergency);
+}
+
+void TrafficNetwork::queue_vehicle(size_t node_idx, Vehicle vehicle, bool is_emergency) {
     if (is_emergency) {
-        nodes[node_idx].emergency_queue.push(vehicle);
+        vehicle.priority = class_priority[node_idx * VEHICLE_CLASS_COUNT + vehicle_class_index(vehicle.type)];
+        nodes[node_idx].emergency_queue.push(move(vehicle));
     } else {
         nodes[node_idx].waiting_queue.push(vehicle);
     }
+    active_nodes.insert(node_idx);
+    touch_node(node_idx);
+}
+
+const Vehicle* TrafficNetwork::queue_head(size_t node_idx) const {
+    const NodeData& node = nodes[node_idx];
+    if (node.has_emergency_vehicles()) return &node.emergency_queue.top();
+    if (!node.waiting_queue.empty()) return &node.waiting_queue.front();
+    return nullptr;
+}
+
+bool TrafficNetwork::dequeue_vehicle(size_t node_idx, Vehicle& vehicle, bool& is_emergency) {
+    NodeData& node = nodes[node_idx];
+    if (node.has_emergency_vehicles()) {
+        vehicle = node.emergency_queue.top();
+        node.emergency_queue.pop();
+        is_emergency = true;
+    } else if (!node.waiting_queue.empty()) {
+        vehicle = node.waiting_queue.front();
+        node.waiting_queue.pop();
+        is_emergency = false;
+    } else {
+        active_nodes.erase(node_idx);
+        return false;
+    }
+
+    if (node.get_queue_size() == 0) {
+        active_nodes.erase(node_idx);
+    }
+    touch_node(node_idx);
+    return true;
+}
+
+void TrafficNetwork::return_vehicle_to_queue(Vehicle& vehicle, size_t node_idx, bool is_emergency) {
+    queue_vehicle(node_idx, vehicle, is_emergency);
 }
 
 int TrafficNetwork::find_best_next_hop(size_t from_node, int destination) {
@@ -850,10 +2180,13 @@ int TrafficNetwork::find_best_next_hop(size_t from_node, int destination) {
     const auto& adjacent = nodes[from_node].adjacent_nodes;
     if (adjacent.empty()) return -1;
 
+    // Also shortest by distance: no detour beats the straight edge
     for (int adj : adjacent) {
         if (adj == destination) return destination;
     }
 
+    if (!spatial_index.empty()) return find_geometric_next_hop(from_node, destination);
+
     // BFS pathfinding
     vector<int> parent(nodes.size(), -1);
     vector<bool> visited(nodes.size(), false);
@@ -885,66 +2218,281 @@ int TrafficNetwork::find_best_next_hop(size_t from_node, int destination) {
     return adjacent[0]; // fallback
 }
 
-bool TrafficNetwork::can_move_to_node_safe(int node_idx, VehicleType vehicle_type) {
+// A* over straight-line edge lengths. The distance to the destination never
+// overestimates the remaining path, so the first pop of the destination is
+// optimal. Tracks each node's first hop instead of parents.
+int TrafficNetwork::find_geometric_next_hop(size_t from_node, int destination) const {
+    const size_t n = nodes.size();
+    vector<double> cost(n, numeric_limits<double>::infinity());
+    vector<int> first_hop(n, -1);
+    vector<bool> closed(n, false);
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> open;
+
+    cost[from_node] = 0.0;
+    open.emplace(spatial_index.distance_between(static_cast<int>(from_node), destination),
+                 static_cast<int>(from_node));
+
+    while (!open.empty()) {
+        int curr = open.top().second;
+        open.pop();
+        if (closed[curr]) continue;
+        if (curr == destination) return first_hop[curr];
+        closed[curr] = true;
+
+        for (int neighbor : nodes[curr].adjacent_nodes) {
+            double through = cost[curr] + spatial_index.distance_between(curr, neighbor);
+            if (through < cost[neighbor]) {
+                cost[neighbor] = through;
+                first_hop[neighbor] = curr == static_cast<int>(from_node) ? neighbor : first_hop[curr];
+                open.emplace(through + spatial_index.distance_between(neighbor, destination), neighbor);
+            }
+        }
+    }
+
+    return nodes[from_node].adjacent_nodes[0]; // fallback, as in BFS
+}
+
+void TrafficNetwork::build_spatial_index() {
+    size_t positioned = 0;
+    for (const auto& p : node_positions) {
+        if (!isnan(p.x) && !isnan(p.y)) positioned++;
+    }
+    if (positioned == 0) return;
+    if (positioned < nodes.size()) {
+        cout << Display::WARNING_ICON << " Node Coordinates cover " << positioned << " of "
+             << nodes.size() << " nodes; ignoring them" << endl;
+        return;
+    }
+
+    // Geographic lines are "lat, lon"; the index stores x = lon, y = lat
+    if (config.geographic_coordinates) {
+        for (auto& p : node_positions) swap(p.x, p.y);
+    }
+    spatial_index.build(node_positions, config.geographic_coordinates);
+    cout << Display::INFO_ICON << " Node coordinates loaded ("
+         << (config.geographic_coordinates ? "geographic" : "planar") << "); routing uses A*" << endl;
+}
+
+void TrafficNetwork::load_gps_trips() {
+    if (spatial_index.empty()) {
+        cout << Display::WARNING_ICON << " GPS_TRACE_FILE needs # Node Coordinates - skipping map matching" << endl;
+        return;
+    }
+
+    vector<GpsTrace> traces;
+    if (!MapMatcher::load_traces(config.gps_trace_file, config.geographic_coordinates, traces)) {
+        cout << Display::WARNING_ICON << " Cannot read GPS traces from " << config.gps_trace_file << endl;
+        return;
+    }
+
+    MapMatchParams params;
+    params.gps_sigma = config.gps_sigma;
+    params.search_radius = config.gps_search_radius;
+    MapMatcher matcher(nodes, spatial_index, params);
+
+    auto start = chrono::steady_clock::now();
+    vector<MatchedTrip> trips;
+    matcher.match_all(traces, trips, *thread_pool);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    size_t pings = 0, breaks = 0;
+    for (const auto& trace : traces) pings += trace.pings.size();
+    for (const auto& trip : trips) breaks += trip.breaks;
+    cout << Display::INFO_ICON << " Map-matched " << pings << " pings in " << traces.size() << " traces ("
+         << llround(seconds > 0.0 ? pings / seconds : 0.0) << " pings/s, "
+         << breaks << " breaks)" << endl;
+    if (MapMatcher::save_trips(config.matched_trips_file, trips)) {
+        cout << Display::INFO_ICON << " Matched trips written to " << config.matched_trips_file << endl;
+    }
+
+    // Replay each trip as a regular vehicle while its origin has room
+    size_t replayed = 0, skipped = 0;
+    for (const auto& trip : trips) {
+        if (trip.nodes.size() < 2) continue;
+        NodeData& origin = nodes[trip.nodes.front()];
+        if (origin.is_at_capacity()) {
+            skipped++;
+            continue;
+        }
+        Vehicle vehicle = make_vehicle(next_vehicle_id++, VehicleType::REGULAR, trip.nodes.front(), trip.nodes.back());
+        vehicle.path = trip.nodes;
+        enqueue_vehicle(origin.node_id, vehicle, false);
+        origin.current_vehicles++;
+        replayed++;
+    }
+    cout << Display::SUCCESS_ICON << " Replaying " << replayed << " matched trips";
+    if (skipped > 0) cout << " (" << skipped << " skipped, origin at capacity)";
+    cout << endl;
+}
+
+bool TrafficNetwork::can_move_to_node_safe(int node_idx, VehicleType vehicle_type) const {
     if (node_idx < 0 || node_idx >= static_cast<int>(nodes.size())) return false;
+    return nodes[node_idx].current_vehicles <
+           class_limit[node_idx * VEHICLE_CLASS_COUNT + vehicle_class_index(vehicle_type)];
+}
 
-    int max_allowed = nodes[node_idx].capacity;
-    if (vehicle_type != VehicleType::REGULAR) {
-        max_allowed += 1; // Emergency vehicles get +1 capacity
+void TrafficNetwork::build_class_limits() {
+    size_t n = nodes.size();
+    if (class_reserved.size() != n * VEHICLE_CLASS_COUNT) class_reserved.assign(n * VEHICLE_CLASS_COUNT, 0);
+    class_limit.assign(n * VEHICLE_CLASS_COUNT, 0);
+    if (class_priority.size() != n * VEHICLE_CLASS_COUNT) {
+        class_priority.resize(n * VEHICLE_CLASS_COUNT);
+        for (size_t i = 0; i < n * VEHICLE_CLASS_COUNT; ++i) {
+            class_priority[i] = VEHICLE_CLASSES[i % VEHICLE_CLASS_COUNT].priority;
+        }
     }
 
-    return nodes[node_idx].current_vehicles < max_allowed;
+    // Emergency classes ignore reservations; every other class loses the
+    // slots reserved for the rest
+    for (size_t i = 0; i < n; ++i) {
+        const int32_t* reserved = &class_reserved[i * VEHICLE_CLASS_COUNT];
+        int32_t total_reserved = 0;
+        for (size_t c = 0; c < VEHICLE_CLASS_COUNT; ++c) total_reserved += reserved[c];
+        for (size_t c = 0; c < VEHICLE_CLASS_COUNT; ++c) {
+            const VehicleClassTraits& traits = VEHICLE_CLASSES[c];
+            int32_t limit = nodes[i].capacity + traits.headroom;
+            if (!traits.emergency) limit -= total_reserved - reserved[c];
+            class_limit[i * VEHICLE_CLASS_COUNT + c] = max(0, limit);
+        }
+    }
 }
 
-void TrafficNetwork::perform_vehicle_move(Vehicle& vehicle, size_t from_node, int to_node) {
+template<class Observer>
+bool TrafficNetwork::perform_vehicle_move(Vehicle& vehicle, size_t from_node, int to_node, Observer& observer) {
+    // Re-check at commit time: another move may have filled the target
+    if (to_node != vehicle.destination_node && !can_move_to_node_safe(to_node, vehicle.type)) {
+        observer.on_bounced(vehicle, from_node);
+        trace(TraceKind::BOUNCE, vehicle, from_node, to_node);
+        record_block(from_node, vehicle);
+        vehicle.blocked_attempts++;
+        return_vehicle_to_queue(vehicle, from_node, vehicle_class(vehicle.type).emergency);
+        return false;
+    }
+
     // Remove from source
     if (nodes[from_node].current_vehicles > 0) {
         nodes[from_node].current_vehicles--;
+        notify_capacity_freed(from_node);
     }
+    if (from_node < node_blocked.size()) node_blocked[from_node] = 0;
+    touch_node(from_node);
+    fairness.leave(from_node, vehicle_class_index(vehicle.type), vehicle.queue_stamp);
 
     vehicle.current_node = to_node;
+    if (vehicle.path_step + 1 < vehicle.path.size() && vehicle.path[vehicle.path_step + 1] == to_node) {
+        vehicle.path_step++;
+    } else {
+        vehicle.path.clear();    // left the matched path; route freely from here
+    }
+    observer.on_move(vehicle, from_node, to_node);
+    trace(TraceKind::HOP, vehicle, from_node, to_node);
 
     // Update stats
     {
         lock_guard<mutex> stats_lock(stats_mutex);
         stats.total_moves++;
+        stats.windows.record_move(stats.elapsed_seconds());
     }
+    record_edge_move(from_node, to_node);
 
     if (to_node == vehicle.destination_node) {
+        observer.on_destination_reached(vehicle);
+
         // Vehicle reached destination
         {
             lock_guard<mutex> stats_lock(stats_mutex);
-            if (vehicle.type == VehicleType::REGULAR) {
-                stats.total_vehicles_processed++;
-            } else {
+            if (vehicle_class(vehicle.type).emergency) {
                 stats.emergency_vehicles_processed++;
+            } else {
+                stats.total_vehicles_processed++;
             }
             stats.successful_routes++;
+            double journey = duration<double>(steady_clock::now() - vehicle.start_time).count();
+            stats.total_journey_time += journey;
+            stats.windows.record_arrival(stats.elapsed_seconds(), journey * 1000.0);
+            trace(TraceKind::ARRIVE, vehicle, to_node, static_cast<int>(llround(journey * 1000.0)));
         }
-        return;
+        return true;
     }
 
-    // Add to destination node
-    int max_capacity = nodes[to_node].capacity;
-    if (vehicle.type != VehicleType::REGULAR) {
-        max_capacity += 1;
+    // Add to destination node, in transit until its travel ends
+    nodes[to_node].current_vehicles++;
+    begin_travel(vehicle, from_node, to_node);
+    observer.on_enqueued(vehicle, to_node);
+    return true;
+}
+
+// ================================
+// CONGESTION RANKING
+// ================================
+
+void TrafficNetwork::build_congestion_tracker() {
+    node_blocked.assign(nodes.size(), 0);
+    vector<CongestionKey> keys(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) keys[i] = congestion_key(i);
+    congestion.build(keys);
+}
+
+CongestionKey TrafficNetwork::congestion_key(size_t node_idx) const {
+    const NodeData& node = nodes[node_idx];
+    CongestionKey key;
+    key.utilization = node.capacity > 0 ? static_cast<float>(node.current_vehicles) / node.capacity : 0.0f;
+    key.queue_depth = node.get_queue_size();
+    key.blocked = node_idx < node_blocked.size() ? node_blocked[node_idx] : 0;
+    return key;
+}
+
+// Every queue or occupancy change lands here: re-key the node in the
+// congestion heap and mark its node_state block for the next refresh
+void TrafficNetwork::touch_node(size_t node_idx) {
+    if (node_idx < congestion.size()) congestion.update(node_idx, congestion_key(node_idx));
+    signals.touch(node_idx);
+    size_t block = node_idx / NodeKernels::BLOCK;
+    if (block < node_state_dirty.size() && !node_state_dirty[block]) {
+        node_state_dirty[block] = 1;
+        dirty_state_blocks.push_back(static_cast<uint32_t>(block));
     }
+}
 
-    if (nodes[to_node].current_vehicles < max_capacity) {
-        nodes[to_node].current_vehicles++;
-        if (vehicle.type == VehicleType::REGULAR) {
-            nodes[to_node].waiting_queue.push(vehicle);
-        } else {
-            nodes[to_node].emergency_queue.push(vehicle);
-        }
-    } else {
-        // Return to source
-        nodes[from_node].current_vehicles++;
-        return_vehicle_to_queue(vehicle, from_node, vehicle.type != VehicleType::REGULAR);
-        vehicle.blocked_attempts++;
+// ================================
+// SAMPLED VEHICLE TRACING
+// ================================
+
+void TrafficNetwork::configure_tracer() {
+    PhiloxBlock key = CounterRng(config.random_seed).draw(0, 0, RandomPurpose::TRACE);
+    tracer.configure(config.trace_sample_rate, (static_cast<uint64_t>(key.v[1]) << 32) | key.v[0],
+                     static_cast<size_t>(config.trace_buffer));
+    if (tracer.enabled()) {
+        cout << Display::INFO_ICON << " Tracing " << fixed << setprecision(1) << config.trace_sample_rate * 100.0
+             << "% of vehicles into " << config.trace_file << endl;
     }
+}
+
+// The sampling hash runs once here; trace points only test Vehicle::traced
+Vehicle TrafficNetwork::make_vehicle(int id, VehicleType type, int source, int destination) const {
+    Vehicle vehicle(id, type, source, destination);
+    vehicle.traced = tracer.sampled(id);
+    return vehicle;
+}
+
+void TrafficNetwork::write_vehicle_trace() {
+    vector<char> names(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) names[i] = nodes[i].node_char;
+    if (!tracer.write(config.trace_file, names)) {
+        cout << Display::WARNING_ICON << " Cannot write vehicle trace " << config.trace_file << endl;
+        return;
+    }
+    cout << Display::INFO_ICON << " Vehicle trace: " << tracer.size() << " events from "
+         << tracer.vehicle_count() << " vehicles written to " << config.trace_file;
+    if (tracer.dropped() > 0) cout << " (" << tracer.dropped() << " dropped, buffer full)";
+    cout << endl;
+}
 
-    this_thread::sleep_for(chrono::milliseconds(100));
+void TrafficNetwork::record_block(size_t from_node, const Vehicle& vehicle) {
+    if (from_node < node_blocked.size()) node_blocked[from_node]++;
+    fairness.block(from_node, vehicle_class_index(vehicle.type));
+    lock_guard<mutex> stats_lock(stats_mutex);
+    stats.windows.record_block(stats.elapsed_seconds());
 }
 
 void TrafficNetwork::attempt_rerouting(Vehicle& vehicle, size_t /* current_node */) {
@@ -953,15 +2501,88 @@ void TrafficNetwork::attempt_rerouting(Vehicle& vehicle, size_t /* current_node
     vehicle.blocked_attempts = 0;
 }
 
+// ================================
+// SHARED-MEMORY STATE EXPORT
+// ================================
+
+void TrafficNetwork::open_state_export() {
+    if (config.state_export_name.empty()) return;
+
+    vector<pair<int, int>> edges;
+    build_edge_offsets();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (int adj : nodes[i].adjacent_nodes) {
+            edges.emplace_back(static_cast<int>(i), adj);
+        }
+    }
+    edge_moves.assign(edges.size(), 0);
+    edge_moves_published.assign(edges.size(), 0);
+
+    if (state_export.open(config.state_export_name, nodes.size(), edges)) {
+        cout << Display::INFO_ICON << " Publishing live state to shared memory "
+             << config.state_export_name << endl;
+    } else {
+        cout << Display::WARNING_ICON << " Cannot create shared memory "
+             << config.state_export_name << " - state export disabled" << endl;
+    }
+}
+
+void TrafficNetwork::record_edge_move(size_t from_node, int to_node) {
+    if (!state_export.is_open()) return;
+    const auto& adjacent = nodes[from_node].adjacent_nodes;
+    for (size_t k = 0; k < adjacent.size(); ++k) {
+        if (adjacent[k] == to_node) {
+            edge_moves[edge_offset[from_node] + k]++;
+            return;
+        }
+    }
+}
+
+void TrafficNetwork::publish_state(double simulated_seconds, const FlowModel* flow) {
+    if (!state_export.is_open()) return;
+
+    // Written straight into the back frame; viewers never block the engine
+    SharedFrame frame = state_export.begin_frame(export_tick++, simulated_seconds);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        int flow_queue = flow ? static_cast<int>(flow->node_occupancy(i)) : 0;
+        frame.occupancy[i] = nodes[i].current_vehicles;
+        frame.queue_depth[i] = nodes[i].get_queue_size() + flow_queue;
+    }
+    for (size_t e = 0; e < edge_moves.size(); ++e) {
+        float moved = static_cast<float>(edge_moves[e] - edge_moves_published[e]);
+        frame.edge_flow[e] = flow ? moved + static_cast<float>(flow->edge_flows()[e]) : moved;
+        edge_moves_published[e] = edge_moves[e];
+    }
+    state_export.end_frame();
+}
+
 // ================================
 // UTILITY METHODS
 // ================================
 
+void TrafficNetwork::enter_loop() {
+    lock_guard<mutex> lock(thread_exit_mutex);
+    active_threads++;
+}
+
+void TrafficNetwork::exit_loop() {
+    {
+        lock_guard<mutex> lock(thread_exit_mutex);
+        active_threads--;
+    }
+    cv_threads_done.notify_all();
+}
+
 void TrafficNetwork::shutdown() {
-    shutdown_requested = true;
-    cv_token_allocation.notify_all();
-    while (active_threads.load() > 0) {
-        this_thread::sleep_for(chrono::milliseconds(10));
+    stop_source.request_stop();
+
+    unique_lock<mutex> lock(thread_exit_mutex);
+    bool joined = cv_threads_done.wait_for(lock,
+                                           chrono::duration<double>(config.shutdown_timeout),
+                                           [this]() { return active_threads.load() == 0; });
+    if (!joined) {
+        cout << Display::WARNING_ICON << " " << active_threads.load()
+             << " simulation loop(s) still running at shutdown" << endl;
     }
     simulation_running = false;
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "vehicle_trace.h"
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <iomanip>
+
+using namespace std;
+using namespace std::chrono;
+
+// ================================
+// SAMPLED VEHICLE TRACING
+// ================================
+
+void VehicleTracer::configure(double rate, uint64_t seed_key, size_t capacity) {
+    rate = min(max(rate, 0.0), 1.0);
+    if (rate <= 0.0 || capacity == 0) threshold = 0;
+    else if (rate >= 1.0) threshold = numeric_limits<uint64_t>::max();
+    else threshold = static_cast<uint64_t>(ldexp(rate, 64));
+    key = seed_key;
+    limit = capacity;
+    overflow = 0;
+    events.clear();
+    events.shrink_to_fit();
+    if (threshold != 0) events.reserve(limit);
+    epoch = steady_clock::now();
+}
+
+void VehicleTracer::record(TraceKind kind, int vehicle_id, int node, int detail) {
+    if (events.size() >= limit) {
+        overflow++;
+        return;
+    }
+    uint32_t time_us = static_cast<uint32_t>(duration_cast<microseconds>(steady_clock::now() - epoch).count());
+    events.push_back(TraceEvent{time_us, vehicle_id, node, detail, kind});
+}
+
+size_t VehicleTracer::vehicle_count() const {
+    vector<int32_t> ids;
+    ids.reserve(events.size());
+    for (const auto& e : events) ids.push_back(e.vehicle_id);
+    sort(ids.begin(), ids.end());
+    return static_cast<size_t>(unique(ids.begin(), ids.end()) - ids.begin());
+}
+
+const char* VehicleTracer::kind_name(TraceKind kind) {
+    switch (kind) {
+        case TraceKind::WAIT: return "WAIT";
+        case TraceKind::HOP: return "HOP";
+        case TraceKind::BLOCK: return "BLOCK";
+        case TraceKind::RED: return "RED";
+        case TraceKind::BOUNCE: return "BOUNCE";
+        case TraceKind::NO_PATH: return "NO_PATH";
+        case TraceKind::REROUTE: return "REROUTE";
+        case TraceKind::ARRIVE: return "ARRIVE";
+    }
+    return "UNKNOWN";
+}
+
+bool VehicleTracer::write(const string& path, const vector<char>& names) const {
+    ofstream out(path);
+    if (!out.is_open()) return false;
+
+    auto node_name = [&names](int32_t node) -> char {
+        return node >= 0 && static_cast<size_t>(node) < names.size() ? names[node] : '?';
+    };
+    out << "time_ms,vehicle,event,node,detail\n" << fixed << setprecision(3);
+    for (const auto& e : events) {
+        out << e.time_us / 1000.0 << ',' << e.vehicle_id << ',' << kind_name(e.kind) << ',' << node_name(e.node) << ',';
+        switch (e.kind) {
+            case TraceKind::HOP:
+            case TraceKind::BLOCK:
+            case TraceKind::RED:
+            case TraceKind::BOUNCE:
+                out << node_name(e.detail);
+                break;
+            case TraceKind::WAIT:
+            case TraceKind::ARRIVE:
+                out << e.detail;
+                break;
+            default:
+                break;
+        }
+        out << '\n';
+    }
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,97 @@
+#include "window_metrics.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// ================================
+// SLIDING-WINDOW METRICS
+// ================================
+
+WindowMetrics::WindowMetrics(double bucket_seconds, size_t history) {
+    configure(bucket_seconds, history);
+}
+
+void WindowMetrics::configure(double bucket_seconds, size_t history) {
+    bucket_width = bucket_seconds > 0.0 ? bucket_seconds : 0.25;
+    ring.assign(max<size_t>(history, 2), Totals{});
+    running = Totals{};
+    head = 0;
+}
+
+void WindowMetrics::advance(double t) {
+    int64_t bucket = static_cast<int64_t>(t / bucket_width);
+    if (bucket <= head) return;
+
+    // Every bucket skipped while idle starts with the same totals; filling
+    // more than one ring's worth would only overwrite itself
+    int64_t first = max(head + 1, bucket - static_cast<int64_t>(ring.size()) + 1);
+    for (int64_t b = first; b <= bucket; ++b) {
+        ring[static_cast<size_t>(b) % ring.size()] = running;
+    }
+    head = bucket;
+}
+
+void WindowMetrics::record_move(double t) {
+    advance(t);
+    running.moves++;
+}
+
+void WindowMetrics::record_moves(double t, uint64_t count) {
+    advance(t);
+    running.moves += count;
+}
+
+void WindowMetrics::record_arrival(double t, double latency_ms) {
+    advance(t);
+    running.arrivals++;
+    running.latency_sum_ms += latency_ms;
+    running.latency_bins[latency_bin(latency_ms)]++;
+}
+
+void WindowMetrics::record_block(double t) {
+    advance(t);
+    running.blocks++;
+}
+
+size_t WindowMetrics::latency_bin(double latency_ms) {
+    if (!(latency_ms > 1.0)) return 0;
+    size_t bin = static_cast<size_t>(4.0 * log2(latency_ms)) + 1;
+    return min(bin, LATENCY_BINS - 1);
+}
+
+double WindowMetrics::bin_upper_ms(size_t bin) {
+    return bin == 0 ? 1.0 : exp2(static_cast<double>(bin) / 4.0);
+}
+
+WindowSummary WindowMetrics::window(double t, double seconds) {
+    advance(t);
+
+    // Oldest bucket the window may start in: within the ring and at or after
+    // the start of the run
+    int64_t buckets = max<int64_t>(1, static_cast<int64_t>(ceil(seconds / bucket_width)));
+    buckets = min(buckets, static_cast<int64_t>(ring.size()));
+    int64_t start = max<int64_t>(0, head - buckets + 1);
+    const Totals& origin = ring[static_cast<size_t>(start) % ring.size()];
+
+    WindowSummary summary;
+    summary.seconds = max(t - start * bucket_width, 1e-9);
+    summary.moves = running.moves - origin.moves;
+    summary.arrivals = running.arrivals - origin.arrivals;
+    summary.blocks = running.blocks - origin.blocks;
+    summary.throughput = summary.moves / summary.seconds;
+    summary.arrival_rate = summary.arrivals / summary.seconds;
+    if (summary.arrivals == 0) return summary;
+
+    summary.latency_mean_ms = (running.latency_sum_ms - origin.latency_sum_ms) / summary.arrivals;
+    uint64_t p50_rank = (summary.arrivals + 1) / 2;
+    uint64_t p95_rank = static_cast<uint64_t>(ceil(0.95 * summary.arrivals));
+    uint64_t seen = 0;
+    for (size_t bin = 0; bin < LATENCY_BINS; ++bin) {
+        uint64_t count = running.latency_bins[bin] - origin.latency_bins[bin];
+        if (seen < p50_rank && seen + count >= p50_rank) summary.latency_p50_ms = bin_upper_ms(bin);
+        if (seen < p95_rank && seen + count >= p95_rank) summary.latency_p95_ms = bin_upper_ms(bin);
+        seen += count;
+    }
+    return summary;
+}